@@ -0,0 +1,233 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2022  Andreas Lagler
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+"""Static worst-case cycle count of functions in an AVR ELF file.
+
+The disassembly of avr-objdump is split into functions, and the longest path through the control flow graph of each
+selected function is computed from the instruction cycle counts of the classic AVR core. Called functions are included
+with their own worst case. Loops cannot be bounded statically: a function containing a loop (or calling one) is reported
+with loop_free = false, and its count covers a single pass through each loop body. Indirect calls are flagged and not
+included. The counts include the final ret, but not the interrupt entry and the prologue/epilogue of the ISR vector.
+"""
+
+import argparse
+import json
+import re
+import subprocess
+import sys
+
+SYMBOL = re.compile(r'^([0-9a-f]+) <([^>]+)>:$')
+INSTRUCTION = re.compile(r'^\s*([0-9a-f]+):\t((?:[0-9a-f]{2} )+)\s*\t?(\S*)\s*(.*)$')
+TARGET_COMMENT = re.compile(r';\s*0x([0-9a-f]+)')
+TARGET_OPERAND = re.compile(r'^0x([0-9a-f]+)')
+
+# Cycle counts of the classic AVR core with 16-bit program counter. Instructions not listed take 1 cycle
+CYCLES = {
+    'adiw': 2, 'sbiw': 2,
+    'mul': 2, 'muls': 2, 'mulsu': 2, 'fmul': 2, 'fmuls': 2, 'fmulsu': 2,
+    'ld': 2, 'ldd': 2, 'lds': 2, 'st': 2, 'std': 2, 'sts': 2, 'push': 2, 'pop': 2,
+    'lpm': 3, 'elpm': 3, 'sbi': 2, 'cbi': 2,
+    'rjmp': 2, 'ijmp': 2, 'eijmp': 2, 'jmp': 3,
+    'rcall': 3, 'icall': 3, 'eicall': 4, 'call': 4,
+    'ret': 4, 'reti': 4,
+}
+
+# Additional cycles of call and return instructions for devices with 22-bit program counter
+PC22_EXTRA = {'rcall': 1, 'icall': 1, 'call': 1, 'ret': 1, 'reti': 1}
+
+SKIPS = {'cpse', 'sbrc', 'sbrs', 'sbic', 'sbis'}
+
+
+class Instruction:
+    def __init__(self, address, size, mnemonic, operands):
+        self.address = address
+        self.size = size
+        self.mnemonic = mnemonic
+        self.operands = operands
+
+    def target(self):
+        match = TARGET_COMMENT.search(self.operands) or TARGET_OPERAND.match(self.operands)
+        return int(match.group(1), 16) if match else None
+
+    def is_branch(self):
+        return self.mnemonic.startswith('br') and self.mnemonic != 'break'
+
+
+class Program:
+    def __init__(self, disassembly, pc22):
+        self.functions = {}
+        self.instructions = {}
+        self.function_at = {}
+        self.pc22 = pc22
+        self.memo = {}
+
+        name = None
+        for line in disassembly.splitlines():
+            symbol = SYMBOL.match(line)
+            if symbol:
+                name = symbol.group(2)
+                self.functions[name] = int(symbol.group(1), 16)
+                continue
+            instruction = INSTRUCTION.match(line)
+            if name and instruction and instruction.group(3):
+                address = int(instruction.group(1), 16)
+                size = len(instruction.group(2).split())
+                self.instructions[address] = Instruction(address, size, instruction.group(3), instruction.group(4))
+                self.function_at[address] = name
+
+    def cycles(self, mnemonic):
+        return CYCLES.get(mnemonic, 1) + (PC22_EXTRA.get(mnemonic, 0) if self.pc22 else 0)
+
+    def analyze(self, name, active=()):
+        """Return (worst-case cycles, loop free, indirect calls) of a function."""
+        if name in self.memo:
+            return self.memo[name]
+        if name in active:
+            # Recursion cannot be bounded
+            return 0, False, False
+
+        state = {'loop_free': True, 'indirect': False}
+        longest = {}
+        on_path = set()
+
+        def callee(address):
+            function = self.function_at.get(address)
+            if function is None or self.functions[function] != address:
+                state['indirect'] = True
+                return 0
+            cycles, loop_free, indirect = self.analyze(function, active + (name,))
+            state['loop_free'] &= loop_free
+            state['indirect'] |= indirect
+            return cycles
+
+        def path(address):
+            if address in longest:
+                return longest[address]
+            if address in on_path:
+                state['loop_free'] = False
+                return 0
+            instruction = self.instructions.get(address)
+            if instruction is None or self.function_at[address] != name:
+                # Fall through into the next function, treated as tail call
+                return callee(address) if instruction else 0
+
+            on_path.add(address)
+            mnemonic = instruction.mnemonic
+            cost = self.cycles(mnemonic)
+            following = address + instruction.size
+            if mnemonic in ('ret', 'reti'):
+                result = cost
+            elif mnemonic in ('rjmp', 'jmp'):
+                target = instruction.target()
+                if target is not None and self.function_at.get(target) == name:
+                    result = cost + path(target)
+                else:
+                    result = cost + (callee(target) if target is not None else 0)
+            elif mnemonic in ('ijmp', 'eijmp'):
+                state['indirect'] = True
+                result = cost
+            elif mnemonic in ('rcall', 'call'):
+                target = instruction.target()
+                result = cost + (callee(target) if target is not None else 0) + path(following)
+            elif mnemonic in ('icall', 'eicall'):
+                state['indirect'] = True
+                result = cost + path(following)
+            elif instruction.is_branch():
+                target = instruction.target()
+                result = max(1 + path(following), 2 + path(target) if target is not None else 0)
+            elif mnemonic in SKIPS:
+                skipped = self.instructions.get(following)
+                skip_cost = 3 if skipped is not None and skipped.size == 4 else 2
+                skip_target = following + (skipped.size if skipped is not None else 2)
+                result = max(1 + path(following), skip_cost + path(skip_target))
+            else:
+                result = cost + path(following)
+            on_path.discard(address)
+            longest[address] = result
+            return result
+
+        result = (path(self.functions[name]), state['loop_free'], state['indirect'])
+        self.memo[name] = result
+        return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--elf', help='ELF file to disassemble')
+    parser.add_argument('--objdump', default='avr-objdump', help='avr-objdump executable')
+    parser.add_argument('--disassembly', help='Read the output of avr-objdump -d from this file instead of an ELF file')
+    parser.add_argument('--prefix', default='isr_', help='Analyze all functions with this prefix')
+    parser.add_argument('--mcu', default='', help='MCU name written to the report')
+    parser.add_argument('--library', choices=['firmware', 'shim'], default='firmware',
+                        help='AVR C++ library the entry points were compiled against, shim = host stand-ins (not firmware code)')
+    parser.add_argument('--pc22', action='store_true', help='Device with 22-bit program counter, e.g. atmega2560')
+    parser.add_argument('--output', help='JSON report file, default is stdout')
+    parser.add_argument('--baseline', help='Previous JSON report. Exit with status 1 if any worst case has increased')
+    args = parser.parse_args()
+
+    # The longest path search recurses once per instruction
+    sys.setrecursionlimit(100000)
+
+    if args.disassembly:
+        with open(args.disassembly) as file:
+            disassembly = file.read()
+    elif args.elf:
+        disassembly = subprocess.run([args.objdump, '-d', args.elf], check=True, capture_output=True, text=True).stdout
+    else:
+        parser.error('either --elf or --disassembly is required')
+
+    program = Program(disassembly, args.pc22)
+    entry_points = []
+    for name in sorted(program.functions):
+        if name.startswith(args.prefix):
+            cycles, loop_free, indirect = program.analyze(name)
+            entry_points.append({'name': name, 'worst_case_cycles': cycles, 'loop_free': loop_free, 'indirect_calls': indirect})
+
+    report = {'mcu': args.mcu, 'library': args.library, 'entry_points': entry_points}
+    text = json.dumps(report, indent=2) + '\n'
+    if args.output:
+        with open(args.output, 'w') as file:
+            file.write(text)
+    else:
+        sys.stdout.write(text)
+
+    if not entry_points:
+        sys.stderr.write('No functions with prefix %s found\n' % args.prefix)
+        return 1
+
+    if args.baseline:
+        with open(args.baseline) as file:
+            baseline_report = json.load(file)
+        # Reports compiled against different libraries are not comparable
+        baseline_library = baseline_report.get('library', 'shim')
+        if baseline_library != args.library:
+            sys.stderr.write('Baseline was compiled against library %s, this report against %s\n' % (baseline_library, args.library))
+            return 1
+        baseline = {entry['name']: entry['worst_case_cycles'] for entry in baseline_report['entry_points']}
+        regressions = [entry for entry in entry_points
+                       if entry['name'] in baseline and entry['worst_case_cycles'] > baseline[entry['name']]]
+        for entry in regressions:
+            sys.stderr.write('%s: %d cycles, baseline %d cycles\n'
+                             % (entry['name'], entry['worst_case_cycles'], baseline[entry['name']]))
+        if regressions:
+            return 1
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,139 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// ISR-facing entry points compiled for the target MCU by the avr_cycle_report target.
+// Each entry point is wrapped into a non-inlined function with C linkage and the prefix isr_, which is analyzed by avr_cycle_report.py
+
+#include "type_traits.h"
+#include "internal_clock.h"
+#include "external_clock.h"
+#include "midi_input.h"
+#include "buffered_midi_output.h"
+#include "swing_clock.h"
+#include "arpeggiator.h"
+
+namespace
+{
+    InternalClock s_internalClock;
+    PhaseAccumulatorClock<10000> s_phaseAccumulatorClock;
+    ExternalClock<> s_externalClock;
+    SwingClock s_swingClock;
+    MidiInput s_midiInput;
+    Arpeggiator s_arpeggiator;
+    
+    volatile uint8_t s_received;
+    volatile uint8_t s_input;
+    volatile uint16_t s_timestamp;
+    volatile uint8_t s_transmitted;
+    
+    // Output driver with minimal cost standing in for the USART
+    struct Usart
+    {
+        static void put(const uint8_t byte)
+        {
+            s_transmitted = byte;
+        }
+        
+        static void enableTxInterrupt()
+        {}
+        
+        static void disableTxInterrupt()
+        {}
+    };
+    
+    using TxBuffer = MidiTxBuffer<Usart, 32>;
+    
+    // Sink with minimal cost, which only keeps the parsed messages from being optimized away
+    struct Sink
+    {
+        template <typename Message>
+        void operator()(const Message& message)
+        {
+            s_received = *reinterpret_cast<const uint8_t*>(&message);
+        }
+    };
+    
+    Sink s_sink;
+}
+
+extern "C" __attribute__((noinline, used)) void isr_internal_clock()
+{
+    s_internalClock.clock();
+}
+
+extern "C" __attribute__((noinline, used)) void isr_phase_accumulator_clock()
+{
+    s_phaseAccumulatorClock.clock();
+}
+
+extern "C" __attribute__((noinline, used)) void isr_external_clock()
+{
+    s_externalClock.clock();
+}
+
+// Includes the bpm measurement with a 32bit division once per quarter note
+extern "C" __attribute__((noinline, used)) void isr_external_clock_filtered(const uint16_t timestamp)
+{
+    s_externalClock.clock(timestamp);
+}
+
+extern "C" __attribute__((noinline, used)) void isr_external_clock_update(const uint16_t now)
+{
+    s_externalClock.update(now);
+}
+
+extern "C" __attribute__((noinline, used)) void isr_swing_clock()
+{
+    s_swingClock.clock();
+}
+
+extern "C" __attribute__((noinline, used)) void isr_midi_input_parse(const uint8_t rxByte)
+{
+    s_midiInput.parse(rxByte, s_sink);
+}
+
+extern "C" __attribute__((noinline, used)) void isr_arpeggiator_clock()
+{
+    s_arpeggiator.clock();
+}
+
+extern "C" __attribute__((noinline, used)) void isr_arpeggiator_clock24ppqn()
+{
+    s_arpeggiator.clock24PPQN();
+}
+
+extern "C" __attribute__((noinline, used)) void isr_midi_tx_empty()
+{
+    TxBuffer::onTxEmpty();
+}
+
+int main()
+{
+    for (;;)
+    {
+        isr_internal_clock();
+        isr_phase_accumulator_clock();
+        isr_external_clock();
+        isr_external_clock_filtered(s_timestamp);
+        isr_external_clock_update(s_timestamp);
+        isr_swing_clock();
+        isr_midi_input_parse(s_input);
+        isr_arpeggiator_clock();
+        isr_arpeggiator_clock24ppqn();
+        isr_midi_tx_empty();
+    }
+}
@@ -0,0 +1,104 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+@brief Minimal benchmark harness collecting throughput results and writing them as JSON
+*/
+class Bench
+{
+    public:
+    
+    /**
+    @brief Constructor
+    @param scale Scale factor applied to all iteration counts, e.g. to get a quick smoke run
+    */
+    explicit Bench(const double scale)
+    :
+    m_scale(scale)
+    {}
+    
+    /**
+    @brief Run a benchmark
+    @param name Name of the benchmark
+    @param unit Unit of the result, e.g. "bytes/s"
+    @param iterations Number of calls to body, scaled by the scale factor
+    @param itemsPerIteration Number of items (bytes, events, operations) processed per call to body
+    @param body Benchmark body
+    */
+    template <typename Body>
+    void run(const char* name, const char* unit, const uint64_t iterations, const uint64_t itemsPerIteration, Body&& body)
+    {
+        const uint64_t nofIterations = (iterations * m_scale < 1.0) ? 1 : static_cast<uint64_t>(iterations * m_scale);
+        
+        const auto start = std::chrono::steady_clock::now();
+        for (uint64_t iteration = 0; iteration < nofIterations; ++iteration)
+        {
+            body();
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        
+        const double seconds = std::chrono::duration<double>(stop - start).count();
+        const double items = static_cast<double>(nofIterations * itemsPerIteration);
+        m_results.push_back({name, unit, (seconds > 0.0) ? items / seconds : 0.0, nofIterations * itemsPerIteration, seconds});
+    }
+    
+    /**
+    @brief Write all results as JSON
+    @param file Output file
+    */
+    void writeJson(FILE* file) const
+    {
+        fprintf(file, "{\n  \"suite\": \"avr_synth_common_host\",\n  \"results\": [\n");
+        for (size_t index = 0; index < m_results.size(); ++index)
+        {
+            const Result& result = m_results[index];
+            fprintf(file, "    {\"name\": \"%s\", \"unit\": \"%s\", \"value\": %.6g, \"items\": %llu, \"seconds\": %.6g}%s\n",
+            result.name.c_str(),
+            result.unit.c_str(),
+            result.value,
+            static_cast<unsigned long long>(result.items),
+            result.seconds,
+            (index + 1 < m_results.size()) ? "," : "");
+        }
+        fprintf(file, "  ]\n}\n");
+    }
+    
+    private:
+    
+    struct Result
+    {
+        std::string name;
+        std::string unit;
+        double value;
+        uint64_t items;
+        double seconds;
+    };
+    
+    double m_scale;
+    std::vector<Result> m_results;
+};
+
+#endif
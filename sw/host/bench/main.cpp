@@ -0,0 +1,303 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Host benchmarks for MidiInput, MidiOutput and Arpeggiator.
+// Usage: host_bench [--quick] [--stream <raw MIDI file>] [--output <JSON file>]
+
+#include "bench.h"
+
+#include "type_traits.h"
+#include "midi_input.h"
+#include "midi_output.h"
+#include "arpeggiator.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    // Sink counting parsed messages
+    struct CountingSink
+    {
+        template <typename Message>
+        void operator()(const Message&)
+        {
+            ++m_nofMessages;
+        }
+        
+        uint32_t m_nofMessages = 0;
+    };
+    
+    // Output driver counting transmitted bytes
+    struct CountingOutput
+    {
+        static void put(const uint8_t byte)
+        {
+            s_checksum = s_checksum + byte;
+            ++s_nofBytes;
+        }
+        
+        static inline volatile uint32_t s_checksum = 0;
+        static inline uint32_t s_nofBytes = 0;
+    };
+    
+    uint32_t s_nofNoteEvents = 0;
+    
+    void onNoteOn(uint8_t, uint8_t)
+    {
+        ++s_nofNoteEvents;
+    }
+    
+    void onNoteOff(uint8_t)
+    {
+        ++s_nofNoteEvents;
+    }
+    
+    // Synthesize a MIDI stream as recorded from a keyboard with controller movements, MIDI clock and occasional SysEx dumps
+    std::vector<uint8_t> synthesizeStream(const size_t size)
+    {
+        std::vector<uint8_t> stream;
+        stream.reserve(size + 64);
+        
+        uint32_t random = 0x12345678;
+        auto next = [&random]()
+        {
+            random = random * 1664525U + 1013904223U;
+            return static_cast<uint8_t>(random >> 24);
+        };
+        
+        while (stream.size() < size)
+        {
+            const uint8_t selector = next() & 0x1F;
+            if (selector < 12)
+            {
+                // Note on/off burst using running status
+                stream.push_back(0x90);
+                for (uint8_t count = 0; count < 4; ++count)
+                {
+                    stream.push_back(next() & 0x7F);
+                    stream.push_back(count & 1 ? 0 : (next() & 0x7F) | 1);
+                }
+            }
+            else if (selector < 20)
+            {
+                // Controller sweep using running status
+                stream.push_back(0xB0);
+                const uint8_t controller = next() & 0x7F;
+                for (uint8_t count = 0; count < 8; ++count)
+                {
+                    stream.push_back(controller);
+                    stream.push_back(next() & 0x7F);
+                }
+            }
+            else if (selector < 24)
+            {
+                stream.push_back(0xE0);
+                stream.push_back(next() & 0x7F);
+                stream.push_back(next() & 0x7F);
+            }
+            else if (selector < 26)
+            {
+                stream.push_back(0xC0);
+                stream.push_back(next() & 0x7F);
+            }
+            else if (selector < 31)
+            {
+                // MIDI clock, which may interrupt any message
+                stream.push_back(0xF8);
+            }
+            else
+            {
+                stream.push_back(0xF0);
+                for (uint8_t count = 0; count < 48; ++count)
+                {
+                    stream.push_back(next() & 0x7F);
+                }
+                stream.push_back(0xF7);
+            }
+        }
+        
+        return stream;
+    }
+    
+    std::vector<uint8_t> readStream(const char* fileName)
+    {
+        std::vector<uint8_t> stream;
+        FILE* file = fopen(fileName, "rb");
+        if (nullptr == file)
+        {
+            fprintf(stderr, "Cannot open %s\n", fileName);
+            return stream;
+        }
+        
+        uint8_t buffer[4096];
+        size_t length;
+        while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        {
+            stream.insert(stream.end(), buffer, buffer + length);
+        }
+        fclose(file);
+        return stream;
+    }
+    
+    void benchMidiInput(Bench& bench, const std::vector<uint8_t>& stream)
+    {
+        const uint8_t* const begin = stream.data();
+        const uint8_t* const end = begin + stream.size();
+        
+        static MidiInput midiInput;
+        static CountingSink sink;
+        
+        bench.run("midi_input_parse_bulk", "bytes/s", 200, stream.size(), [&]()
+        {
+            midiInput.parse(begin, end, sink);
+        });
+        
+        bench.run("midi_input_parse_byte", "bytes/s", 200, stream.size(), [&]()
+        {
+            for (const uint8_t* byte = begin; byte != end; ++byte)
+            {
+                midiInput.parse(*byte, sink);
+            }
+        });
+        
+        bench.run("midi_input_parse_optional", "bytes/s", 200, stream.size(), [&]()
+        {
+            for (const uint8_t* byte = begin; byte != end; ++byte)
+            {
+                if (midiInput.parse(*byte))
+                {
+                    ++sink.m_nofMessages;
+                }
+            }
+        });
+    }
+    
+    void benchMidiOutput(Bench& bench)
+    {
+        using Output = MidiOutput<CountingOutput>;
+        
+        bench.run("midi_output_note_on", "bytes/s", 2000000, 3, []()
+        {
+            Output::write(MidiNoteOn(MidiChannel::_1, 60, 100));
+        });
+        
+        bench.run("midi_output_control_change", "bytes/s", 2000000, 3, []()
+        {
+            Output::writeControlChange(MidiChannel::_2, 74, 64);
+        });
+    }
+    
+    void benchArpeggiator(Bench& bench)
+    {
+        static Arpeggiator arpeggiator;
+        arpeggiator.registerNoteOnObserver({onNoteOn});
+        arpeggiator.registerNoteOffObserver({onNoteOff});
+        arpeggiator.setParam(ArpeggiatorParam::MODE, static_cast<uint8_t>(ArpeggiatorMode::NORMAL));
+        
+        static const uint8_t chord[] = {48, 52, 55, 59, 60, 64, 67, 71};
+        
+        // Steps per second for each pattern with a held chord
+        for (uint8_t pattern = 0; pattern < static_cast<uint8_t>(ArpeggiatorPattern::NOFENTRIES); ++pattern)
+        {
+            arpeggiator.clear();
+            arpeggiator.setParam(ArpeggiatorParam::PATTERN, pattern);
+            for (const uint8_t note : chord)
+            {
+                arpeggiator.addNote(note);
+            }
+            
+            char name[48];
+            snprintf(name, sizeof(name), "arpeggiator_clock_pattern_%u", pattern);
+            bench.run(name, "events/s", 2000000, 1, []()
+            {
+                arpeggiator.clock();
+            });
+        }
+        
+        // Key churn while the arpeggiator is running, one operation is a single addNote() or removeNote() call
+        arpeggiator.clear();
+        arpeggiator.setParam(ArpeggiatorParam::PATTERN, static_cast<uint8_t>(ArpeggiatorPattern::UPDOWN));
+        bench.run("arpeggiator_note_churn", "ops/s", 200000, 2 * sizeof(chord), []()
+        {
+            for (const uint8_t note : chord)
+            {
+                arpeggiator.addNote(note);
+            }
+            arpeggiator.clock();
+            for (const uint8_t note : chord)
+            {
+                arpeggiator.removeNote(note);
+            }
+        });
+    }
+}
+
+int main(const int argc, const char* const argv[])
+{
+    double scale = 1.0;
+    const char* streamFile = nullptr;
+    const char* outputFile = nullptr;
+    
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        if (0 == strcmp(argv[arg], "--quick"))
+        {
+            scale = 0.01;
+        }
+        else if (0 == strcmp(argv[arg], "--stream") && arg + 1 < argc)
+        {
+            streamFile = argv[++arg];
+        }
+        else if (0 == strcmp(argv[arg], "--output") && arg + 1 < argc)
+        {
+            outputFile = argv[++arg];
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [--quick] [--stream <raw MIDI file>] [--output <JSON file>]\n", argv[0]);
+            return 2;
+        }
+    }
+    
+    const std::vector<uint8_t> stream = streamFile ? readStream(streamFile) : synthesizeStream(64 * 1024);
+    if (stream.empty())
+    {
+        return 1;
+    }
+    
+    Bench bench(scale);
+    benchMidiInput(bench, stream);
+    benchMidiOutput(bench);
+    benchArpeggiator(bench);
+    
+    FILE* file = outputFile ? fopen(outputFile, "w") : stdout;
+    if (nullptr == file)
+    {
+        fprintf(stderr, "Cannot open %s\n", outputFile);
+        return 1;
+    }
+    
+    bench.writeJson(file);
+    if (file != stdout)
+    {
+        fclose(file);
+    }
+    
+    return 0;
+}
@@ -0,0 +1,52 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Host stand-in for optional.h of the AVR C++ library
+
+#ifndef OPTIONAL_H
+#define OPTIONAL_H
+
+template <typename T>
+class Optional
+{
+    public:
+    
+    Optional() = default;
+    
+    Optional(const T& value)
+    :
+    m_value(value),
+    m_hasValue(true)
+    {}
+    
+    explicit operator bool() const
+    {
+        return m_hasValue;
+    }
+    
+    const T& operator*() const
+    {
+        return m_value;
+    }
+    
+    private:
+    
+    T m_value {};
+    bool m_hasValue {false};
+};
+
+#endif
@@ -0,0 +1,92 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Host stand-in for param.h of the AVR C++ library
+
+#ifndef PARAM_H
+#define PARAM_H
+
+#include "type_traits.h"
+
+template <typename T>
+class Param
+{
+    public:
+    
+    constexpr Param() = default;
+    
+    constexpr Param(const T value)
+    :
+    m_value(value)
+    {}
+    
+    constexpr Param& operator=(const T value)
+    {
+        m_value = value;
+        return *this;
+    }
+    
+    constexpr operator T() const
+    {
+        return m_value;
+    }
+    
+    constexpr T getValue() const
+    {
+        return m_value;
+    }
+    
+    constexpr T increment()
+    {
+        return increment(numeric_limits<T>::max());
+    }
+    
+    constexpr T decrement()
+    {
+        return decrement(numeric_limits<T>::min());
+    }
+    
+    constexpr T increment(const T max)
+    {
+        if (m_value < max)
+        {
+            ++m_value;
+        }
+        return m_value;
+    }
+    
+    constexpr T decrement(const T min)
+    {
+        if (m_value > min)
+        {
+            --m_value;
+        }
+        return m_value;
+    }
+    
+    constexpr T incrementRollover(const T min, const T max)
+    {
+        m_value = (m_value < max) ? static_cast<T>(m_value + 1) : min;
+        return m_value;
+    }
+    
+    private:
+    
+    T m_value {};
+};
+
+#endif
@@ -0,0 +1,79 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Host stand-in for subject.h of the AVR C++ library, providing a single observer per subject
+
+#ifndef SUBJECT_H
+#define SUBJECT_H
+
+template <typename... Args>
+class Subject
+{
+    public:
+    
+    struct Observer
+    {
+        void (*callback)(Args...);
+    };
+    
+    constexpr void registerObserver(const Observer& observer)
+    {
+        m_callback = observer.callback;
+    }
+    
+    constexpr void notifyObserver(Args... args) const
+    {
+        if (m_callback)
+        {
+            m_callback(args...);
+        }
+    }
+    
+    private:
+    
+    void (*m_callback)(Args...) = nullptr;
+};
+
+template <>
+class Subject<void>
+{
+    public:
+    
+    struct Observer
+    {
+        void (*callback)();
+    };
+    
+    constexpr void registerObserver(const Observer& observer)
+    {
+        m_callback = observer.callback;
+    }
+    
+    constexpr void notifyObserver() const
+    {
+        if (m_callback)
+        {
+            m_callback();
+        }
+    }
+    
+    private:
+    
+    void (*m_callback)() = nullptr;
+};
+
+#endif
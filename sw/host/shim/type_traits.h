@@ -0,0 +1,42 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Host stand-in for type_traits.h of the AVR C++ library
+
+#ifndef TYPE_TRAITS_H
+#define TYPE_TRAITS_H
+
+#include <stdint.h>
+
+template <typename T>
+struct numeric_limits;
+
+template <>
+struct numeric_limits<uint8_t>
+{
+    static constexpr uint8_t max() { return 0xFF; }
+    static constexpr uint8_t min() { return 0; }
+};
+
+template <>
+struct numeric_limits<uint16_t>
+{
+    static constexpr uint16_t max() { return 0xFFFF; }
+    static constexpr uint16_t min() { return 0; }
+};
+
+#endif
@@ -0,0 +1,71 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Host stand-in for variant.h of the AVR C++ library. Only construction is supported
+
+#ifndef VARIANT_H
+#define VARIANT_H
+
+#include <stdint.h>
+#include <string.h>
+
+template <typename T>
+struct in_place_type_t
+{
+    explicit constexpr in_place_type_t() = default;
+};
+
+template <typename... Types>
+class Variant
+{
+    public:
+    
+    Variant() = default;
+    
+    template <typename T>
+    Variant(in_place_type_t<T>, const T& value)
+    {
+        static_assert(sizeof(T) <= sizeof(m_storage));
+        memcpy(m_storage, &value, sizeof(T));
+        m_index = indexOf<T, Types...>();
+    }
+    
+    uint8_t index() const
+    {
+        return m_index;
+    }
+    
+    private:
+    
+    template <typename T, typename First, typename... Rest>
+    static constexpr uint8_t indexOf()
+    {
+        if constexpr (sizeof...(Rest) == 0)
+        {
+            return 0;
+        }
+        else
+        {
+            return (__is_same(T, First)) ? 0 : 1 + indexOf<T, Rest...>();
+        }
+    }
+    
+    uint8_t m_storage[4] {};
+    uint8_t m_index {0};
+};
+
+#endif
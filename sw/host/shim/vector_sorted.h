@@ -0,0 +1,142 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Host stand-in for vector_sorted.h of the AVR C++ library, providing Vector and VectorSorted
+
+#ifndef VECTOR_SORTED_H
+#define VECTOR_SORTED_H
+
+#include <stdint.h>
+
+enum class SortOrder : uint8_t
+{
+    ASCENDING,
+    DESCENDING
+};
+
+// Reverse iterator over a contiguous array
+template <typename T>
+struct ReverseIterator
+{
+    T* m_ptr;
+    
+    constexpr T& operator*() const { return *(m_ptr - 1); }
+    constexpr ReverseIterator& operator++() { --m_ptr; return *this; }
+    constexpr ReverseIterator operator++(int) { ReverseIterator it = *this; --m_ptr; return it; }
+};
+
+template <typename T, typename Size, Size t_capacity>
+class Vector
+{
+    public:
+    
+    constexpr Vector(const Size length = 0)
+    :
+    m_length(length)
+    {}
+    
+    template <typename Other>
+    constexpr Vector& operator=(const Other& other)
+    {
+        m_length = 0;
+        for (const T& value : other)
+        {
+            m_data[m_length++] = value;
+        }
+        return *this;
+    }
+    
+    constexpr Size length() const { return m_length; }
+    constexpr void resize(const Size length) { m_length = length; }
+    constexpr void clear() { m_length = 0; }
+    
+    constexpr T& operator[](const Size index) { return m_data[index]; }
+    constexpr const T& operator[](const Size index) const { return m_data[index]; }
+    
+    constexpr T* begin() { return m_data; }
+    constexpr T* end() { return m_data + m_length; }
+    constexpr const T* begin() const { return m_data; }
+    constexpr const T* end() const { return m_data + m_length; }
+    constexpr ReverseIterator<T> rbegin() { return {end()}; }
+    
+    private:
+    
+    T m_data[t_capacity] {};
+    Size m_length {0};
+};
+
+template <typename T, typename Size, Size t_capacity, SortOrder t_sortOrder>
+class VectorSorted
+{
+    public:
+    
+    // Insert a value at its sorted position. Returns false if the vector is full
+    constexpr bool insert(const T value)
+    {
+        if (m_length >= t_capacity)
+        {
+            return false;
+        }
+        
+        Size index = m_length;
+        while (index > 0 && isBefore(value, m_data[index - 1]))
+        {
+            m_data[index] = m_data[index - 1];
+            --index;
+        }
+        m_data[index] = value;
+        ++m_length;
+        return true;
+    }
+    
+    // Remove the first occurrence of a value
+    constexpr void remove(const T value)
+    {
+        for (Size index = 0; index < m_length; ++index)
+        {
+            if (m_data[index] == value)
+            {
+                for (; index + 1 < m_length; ++index)
+                {
+                    m_data[index] = m_data[index + 1];
+                }
+                --m_length;
+                return;
+            }
+        }
+    }
+    
+    constexpr Size length() const { return m_length; }
+    constexpr void clear() { m_length = 0; }
+    
+    constexpr const T& operator[](const Size index) const { return m_data[index]; }
+    
+    constexpr const T* begin() const { return m_data; }
+    constexpr const T* end() const { return m_data + m_length; }
+    
+    private:
+    
+    static constexpr bool isBefore(const T lhs, const T rhs)
+    {
+        return (SortOrder::ASCENDING == t_sortOrder) ? (lhs < rhs) : (rhs < lhs);
+    }
+    
+    T m_data[t_capacity] {};
+    Size m_length {0};
+};
+
+#endif
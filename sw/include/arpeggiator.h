@@ -24,97 +24,64 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 //#include "MidiTypes.h"
 #include "Param.h"
 #include "vector_sorted.h"
-#include "clock_divider.h"
-#include "lookup_table.h"
-#include <stdlib.h> // rand()
+#include "progmem_table.h"
+#include "xorshift.h"
+#include "param_slew.h"
+#include <util/atomic.h>
 
 
-static constexpr void updatePatternUP(const auto& keys, auto& notes)
+// Step to key index mappings of the arpeggiator patterns
+// Each pattern is defined by the number of steps and the index of the played key per step, given the number of held keys sorted in ascending order
+
+static constexpr uint8_t getNofStepsUP(const uint8_t nofKeys)
 {
-    notes = keys;
+    return nofKeys;
 }
 
-static constexpr void updatePatternDOWN(const auto& keys, auto& notes)
+static constexpr uint8_t getKeyIndexUP(const uint8_t step, const uint8_t /*nofKeys*/)
 {
-    notes.resize(keys.length());
-    auto dst = notes.rbegin();
-    for (const auto key : keys)
-    {
-        *dst++ = key;
-    }
+    return step;
 }
 
-static constexpr void updatePatternUPDOWN(const auto& keys, auto& notes)
+static constexpr uint8_t getNofStepsDOWN(const uint8_t nofKeys)
 {
-    const uint8_t nofKeys = keys.length();
-    switch (nofKeys)
-    {
-        case 0:
-        case 1:
-        case 2:
-        // 0 Notes held --> 0 steps
-        // 1 Note held --> 1 step
-        // 2 Notes held --> 2 steps
-        notes = keys;
-        break;
-        
-        default:
-        // N Notes held --> 2 * (N-1) steps, e.g. 4 Notes --> 1 2 3 4 3 2 = 6 steps
-        {
-            notes.resize((nofKeys-1) << 1);
-            auto dst = notes.begin();
-            auto src = keys.begin();
-            
-            for (;src < keys.end(); ++src, ++dst)
-            {
-                *dst = *src;
-            }
-            
-            for (--src, --src; src > keys.begin(); --src, ++dst)
-            {
-                *dst = *src;
-            }
-        }
-        break;
-    }
+    return nofKeys;
 }
 
-static constexpr void updatePatternUPDOWNNHOLD(const auto& keys, auto& notes)
+static constexpr uint8_t getKeyIndexDOWN(const uint8_t step, const uint8_t nofKeys)
 {
-    const uint8_t nofKeys = keys.length();
-    switch (nofKeys)
-    {
-        case 0:
-        case 1:
-        // 0 Notes held --> 0 steps
-        // 1 Note held --> 1 step
-        notes = keys;
-        break;
-        
-        default:
-        // N Notes held --> 2 * N steps, e.g. 4 Notes --> 1 2 3 4 4 3 2 1 = 8 steps
-        {
-            notes.resize(nofKeys << 1);
-            auto dst = notes.begin();
-            auto src = keys.begin();
-            
-            for (; src < keys.end(); ++src, ++dst)
-            {
-                *dst = *src;
-            }
-            
-            for (--src; src >= keys.begin(); --src, ++dst)
-            {
-                *dst = *src;
-            }
-        }
-        break;
-    }
+    return nofKeys - 1 - step;
 }
 
+static constexpr uint8_t getNofStepsUPDOWN(const uint8_t nofKeys)
+{
+    // 0 Notes held --> 0 steps
+    // 1 Note held --> 1 step
+    // 2 Notes held --> 2 steps
+    // N Notes held --> 2 * (N-1) steps, e.g. 4 Notes --> 1 2 3 4 3 2 = 6 steps
+    return (nofKeys > 2) ? ((nofKeys - 1) << 1) : nofKeys;
+}
 
+static constexpr uint8_t getKeyIndexUPDOWN(const uint8_t step, const uint8_t nofKeys)
+{
+    return (step < nofKeys) ? step : (((nofKeys - 1) << 1) - step);
+}
 
+static constexpr uint8_t getNofStepsUPDOWNHOLD(const uint8_t nofKeys)
+{
+    // 0 Notes held --> 0 steps
+    // 1 Note held --> 1 step
+    // N Notes held --> 2 * N steps, e.g. 4 Notes --> 1 2 3 4 4 3 2 1 = 8 steps
+    return (nofKeys > 1) ? (nofKeys << 1) : nofKeys;
+}
+
+static constexpr uint8_t getKeyIndexUPDOWNHOLD(const uint8_t step, const uint8_t nofKeys)
+{
+    return (step < nofKeys) ? step : ((nofKeys << 1) - 1 - step);
+}
 
+static_assert(6 == getNofStepsUPDOWN(4) && 2 == getKeyIndexUPDOWN(4, 4) && 1 == getKeyIndexUPDOWN(5, 4));
+static_assert(8 == getNofStepsUPDOWNHOLD(4) && 3 == getKeyIndexUPDOWNHOLD(4, 4) && 0 == getKeyIndexUPDOWNHOLD(7, 4));
 
 
 /**
@@ -125,104 +92,181 @@ class ArpeggiatorParams
 {
     public:
     
+    /**
+    @brief Version of the serialized data format
+    Increment whenever the parameter set or the bit packing changes
+    */
+    static constexpr uint8_t s_version = 2;
+    
     /**
     @brief Size of serialized data in bytes
     */
     static constexpr uint8_t size()
     {
-        return 5;
+        // Version byte followed by the bit-packed parameters
+        return 1 + ((getBitOffset(ArpeggiatorParam::NOFENTRIES) + 7) >> 3);
     }
     
-    void setParam(const ArpeggiatorParam param, const uint8_t value)
+    /**
+    @brief Serialize all parameters, e.g. for a SysEx dump
+    The parameter changes tracked for serializeDelta() are not affected
+    @param data Destination buffer of size() bytes
+    */
+    void serialize(uint8_t* data) const
     {
-        m_params[static_cast<uint8_t>(param)] = value;
+        data[0] = s_version;
+        for (uint8_t idx = 1; idx < size(); ++idx)
+        {
+            data[idx] = 0;
+        }
         
-        switch (param)
+        for (uint8_t idx = 0; idx < static_cast<uint8_t>(ArpeggiatorParam::NOFENTRIES); ++idx)
         {
-            case ArpeggiatorParam::SPEED:
-            case ArpeggiatorParam::SCALE:
-            updateBPMClock();
-            break;
-            default:
-            break;
+            const ArpeggiatorParam param = static_cast<ArpeggiatorParam>(idx);
+            writeField(data, param, getParam(param));
+        }
+    }
+    
+    /**
+    @brief Serialize parameters changed since the last call of serializeDelta() or deserialize() into an existing image
+    Only the bytes flagged in the result need to be written to non-volatile memory
+    @param image Previously serialized data of size() bytes, e.g. a RAM copy of the EEPROM content
+    @result Bit mask of modified bytes in the image, bit n corresponds to byte n
+    */
+    uint8_t serializeDelta(uint8_t* image)
+    {
+        // Outdated images are rewritten entirely. Changes during serialization are flagged again and picked up by the next call
+        if (image[0] != s_version)
+        {
+            takeDirty();
+            serialize(image);
+            return static_cast<uint8_t>((1U << size()) - 1);
         }
         
-        notify(param);
+        uint8_t changedBytes = 0;
+        uint16_t dirty = takeDirty();
+        for (uint8_t idx = 0; dirty; ++idx, dirty >>= 1)
+        {
+            if (dirty & 1)
+            {
+                const ArpeggiatorParam param = static_cast<ArpeggiatorParam>(idx);
+                changedBytes |= writeField(image, param, getParam(param));
+            }
+        }
+        
+        return changedBytes;
     }
-
-    void incParam(const ArpeggiatorParam param)
+    
+    /**
+    @brief Deserialize all parameters
+    Out-of-range values are clamped to the parameter limits
+    @param data Serialized data of size() bytes
+    @result true if the data has been loaded, false if the data version does not match
+    */
+    bool deserialize(const uint8_t* data)
     {
-        // Get parameter type
-        const ArpeggiatorParamType paramType = getParamType(param);
-
-        // Perform the actual increment operation considering the parameter limits
-        const uint8_t maxValue = getMaxValue(paramType);
+        if (data[0] != s_version)
+        {
+            return false;
+        }
         
-        m_params[static_cast<uint8_t>(param)].increment(maxValue);
+        for (uint8_t idx = 0; idx < static_cast<uint8_t>(ArpeggiatorParam::NOFENTRIES); ++idx)
+        {
+            const ArpeggiatorParam param = static_cast<ArpeggiatorParam>(idx);
+            const ArpeggiatorParamDescriptor descriptor = getParamDescriptorP(param);
+            const uint8_t value = readField(data, param);
+            m_params[idx] = (value > descriptor.max) ? descriptor.max : ((value < descriptor.min) ? descriptor.min : value);
+        }
         
-        switch (param)
+        // Loaded values are applied without smoothing
+        updateSlewRate();
+        m_speed.setValue(getParam(ArpeggiatorParam::SPEED));
+        m_velocity.setValue(getParam(ArpeggiatorParam::VELOCITY));
+        updateBPMClock();
+        takeDirty();
+        
+        for (uint8_t idx = 0; idx < static_cast<uint8_t>(ArpeggiatorParam::NOFENTRIES); ++idx)
         {
-            case ArpeggiatorParam::SPEED:
-            case ArpeggiatorParam::SCALE:
-            updateBPMClock();
-            break;
-            default:
-            break;
+            notify(static_cast<ArpeggiatorParam>(idx));
         }
         
-        notify(param);
+        return true;
     }
-
-    void decParam(const ArpeggiatorParam param)
+    
+    /**
+    @brief Check for parameter changes since the last call of serializeDelta() or deserialize()
+    */
+    [[nodiscard]] bool isDirty() const
     {
-        // Get parameter type
-        const ArpeggiatorParamType paramType = getParamType(param);
+        bool dirty;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            dirty = 0 != m_dirty;
+        }
+        return dirty;
+    }
+    
+    void setParam(const ArpeggiatorParam param, const uint8_t value)
+    {
+        m_params[static_cast<uint8_t>(param)] = value;
+        
+        onParamChange(param, getParamDescriptorP(param));
+    }
 
+    void incParam(const ArpeggiatorParam param)
+    {
+        const ArpeggiatorParamDescriptor descriptor = getParamDescriptorP(param);
+        
         // Perform the actual increment operation considering the parameter limits
-        const uint8_t minValue = getMinValue(paramType);
+        m_params[static_cast<uint8_t>(param)].increment(descriptor.max);
+        
+        onParamChange(param, descriptor);
+    }
 
-        m_params[static_cast<uint8_t>(param)].decrement(minValue);
+    void decParam(const ArpeggiatorParam param)
+    {
+        const ArpeggiatorParamDescriptor descriptor = getParamDescriptorP(param);
         
-        switch (param)
-        {
-            case ArpeggiatorParam::SPEED:
-            case ArpeggiatorParam::SCALE:
-            updateBPMClock();
-            break;
-            default:
-            break;
-        }
+        // Perform the actual decrement operation considering the parameter limits
+        m_params[static_cast<uint8_t>(param)].decrement(descriptor.min);
         
-        notify(param);
+        onParamChange(param, descriptor);
     }
 
     // Increment parameter and roll-over (e.g. on push button event)
     void toggleParam(const ArpeggiatorParam param)
     {
-        // Get parameter type
-        const ArpeggiatorParamType paramType = getParamType(param);
-
+        const ArpeggiatorParamDescriptor descriptor = getParamDescriptorP(param);
+        
         // Perform the actual increment operation considering the parameter limits
-        const uint8_t minValue = getMinValue(paramType);
-        const uint8_t maxValue = getMaxValue(paramType);
-        m_params[static_cast<uint8_t>(param)].incrementRollover(minValue, maxValue);
+        m_params[static_cast<uint8_t>(param)].incrementRollover(descriptor.min, descriptor.max);
         
-        switch (param)
+        onParamChange(param, descriptor);
+    }
+
+    [[nodiscard]] constexpr uint8_t getParam(const ArpeggiatorParam param) const
+    {
+        return m_params[static_cast<uint8_t>(param)];
+    }
+    
+    /**
+    @brief Advance the smoothed parameters SPEED and VELOCITY by one tick, e.g. on each 24 PPQN clock tick
+    The BPM clock is only updated if the smoothed speed has changed
+    */
+    void tickSlew()
+    {
+        if (m_speed.tick())
         {
-            case ArpeggiatorParam::SPEED:
-            case ArpeggiatorParam::SCALE:
             updateBPMClock();
-            break;
-            default:
-            break;
         }
         
-        notify(param);
+        m_velocity.tick();
     }
-
-    [[nodiscard]] constexpr uint8_t getParam(const ArpeggiatorParam param) const
+    
+    // Get smoothed velocity
+    [[nodiscard]] constexpr uint8_t getVelocity() const
     {
-        return m_params[static_cast<uint8_t>(param)];
+        return m_velocity.getValue();
     }
     
     // Get clock interval in milliseconds
@@ -232,6 +276,39 @@ class ArpeggiatorParams
     }
     
 
+    /**
+    @brief Enable or disable deferred observer notification
+    In deferred mode, parameter changes (e.g. from an encoder ISR) are only flagged. The observers are notified by dispatchPending()
+    @param deferred Flag indicating deferred notification
+    */
+    constexpr void setDeferredNotification(const bool deferred)
+    {
+        m_deferredNotification = deferred;
+    }
+    
+    /**
+    @brief Notify observers about all parameters changed since the last call, e.g. from the main loop
+    Repeated changes of a parameter are coalesced into a single notification with the current value
+    */
+    void dispatchPending()
+    {
+        uint16_t pending;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            pending = m_pendingNotification;
+            m_pendingNotification = 0;
+        }
+        
+        for (uint8_t idx = 0; pending; ++idx, pending >>= 1)
+        {
+            if (pending & 1)
+            {
+                const ArpeggiatorParam param = static_cast<ArpeggiatorParam>(idx);
+                m_subjectParamUpdate.notifyObserver(param, getParam(param));
+            }
+        }
+    }
+
     void registerParamObserver(const typename Subject<ArpeggiatorParam, uint8_t>::Observer& observer)
     {
         m_subjectParamUpdate.registerObserver(observer);
@@ -239,38 +316,208 @@ class ArpeggiatorParams
     
     constexpr ArpeggiatorParams()
     {
-        m_params[static_cast<uint8_t>(ArpeggiatorParam::MODE)] = static_cast<uint8_t>(ArpeggiatorMode::OFF);
-        m_params[static_cast<uint8_t>(ArpeggiatorParam::SCALE)] = static_cast<uint8_t>(Scale::_1_4);
-        m_params[static_cast<uint8_t>(ArpeggiatorParam::VELOCITY)] = 127;
+        for (uint8_t idx = 0; idx < static_cast<uint8_t>(ArpeggiatorParam::NOFENTRIES); ++idx)
+        {
+            m_params[idx] = getParamDescriptor(idx).defaultValue;
+        }
         
-        updateBPMClock();
+        m_speed.setValue(getParam(ArpeggiatorParam::SPEED));
+        m_velocity.setValue(getParam(ArpeggiatorParam::VELOCITY));
+        
+        // The lookup tables stored in progmem cannot be read in constant expressions
+        m_clock = getWholeNotePeriod(m_speed.getValue()) >> getParam(ArpeggiatorParam::SCALE);
     }
     
     uint16_t m_clock {0};
     
     private:
     
+    // Get the length of a whole note in milliseconds for a BPM speed parameter value
+    static constexpr uint16_t getWholeNotePeriod(const uint16_t bpmSpeed)
+    {
+        // Convert 0..255 to 45..300 BPM, a whole note lasts 4 quarter notes
+        return static_cast<uint16_t>((4 * 60000UL) / (bpmSpeed + 45));
+    }
+    
     // Update BPM clock from BPM speed and arpeggiator scale
-    constexpr void updateBPMClock()
+    void updateBPMClock()
     {
-        // Convert 1/4 note to 1/32 note BPM
-        uint16_t bpmSpeed = getParam(ArpeggiatorParam::SPEED);
-        bpmSpeed += 45; // Convert 0..255 to 45..300 BPM
-        uint16_t bpmScaled = bpmSpeed << (getParam(ArpeggiatorParam::SCALE)-static_cast<uint8_t>(Scale::_1_4)); // Multiply BPM speed with scale
-        m_clock = 60000U / bpmScaled; // Convert BPM speed to clock interval in milliseconds
+        static constexpr const PROGMEM ProgmemTable<uint16_t, 256> wholeNotePeriod(getWholeNotePeriod);
+        
+        // Each finer scale halves the clock interval. Shifting the whole note period yields the same result as dividing by the scaled BPM speed
+        m_clock = wholeNotePeriod.getP(m_speed.getValue()) >> getParam(ArpeggiatorParam::SCALE);
+    }
+    
+    // Update slew rate of smoothed parameters from the SLEW parameter. Returns true if the smoothed speed has changed
+    constexpr bool updateSlewRate()
+    {
+        // Larger values yield slower ramps, e.g. 64 --> 1 per tick, 255 --> 1/4 per tick. Without smoothing, running ramps end at once
+        const uint8_t slew = getParam(ArpeggiatorParam::SLEW);
+        const uint16_t increment = (0 == slew) ? 0 : (0x4000U / slew);
+        m_velocity.setRate(increment);
+        return m_speed.setRate(increment);
     }
 
+    // Get the number of bits required to store a parameter value
+    static constexpr uint8_t getBitWidth(const ArpeggiatorParam param)
+    {
+        uint8_t maxValue = getParamDescriptor(static_cast<uint8_t>(param)).max;
+        uint8_t nofBits = 0;
+        while (maxValue)
+        {
+            ++nofBits;
+            maxValue >>= 1;
+        }
+        return nofBits;
+    }
+    
+    // Get the bit offset of a parameter value within the packed data following the version byte
+    static constexpr uint8_t getBitOffset(const ArpeggiatorParam param)
+    {
+        uint8_t offset = 0;
+        for (uint8_t idx = 0; idx < static_cast<uint8_t>(param); ++idx)
+        {
+            offset += getBitWidth(static_cast<ArpeggiatorParam>(idx));
+        }
+        return offset;
+    }
+    
+    // Write a parameter value into serialized data and return a bit mask of modified bytes.
+    // A field of up to 8 bits spans at most two bytes
+    static uint8_t writeField(uint8_t* data, const ArpeggiatorParam param, const uint8_t value)
+    {
+        const uint8_t offset = getBitOffset(param);
+        const uint8_t byteIdx = 1 + (offset >> 3);
+        const uint8_t shift = offset & 7;
+        const uint16_t mask = ((1U << getBitWidth(param)) - 1) << shift;
+        const uint16_t field = (static_cast<uint16_t>(value) << shift) & mask;
+        
+        uint8_t changedBytes = 0;
+        for (uint8_t idx = 0; idx < 2; ++idx)
+        {
+            const uint8_t maskByte = static_cast<uint8_t>(mask >> (idx << 3));
+            if (maskByte)
+            {
+                const uint8_t oldByte = data[byteIdx + idx];
+                const uint8_t newByte = (oldByte & ~maskByte) | static_cast<uint8_t>(field >> (idx << 3));
+                if (newByte != oldByte)
+                {
+                    data[byteIdx + idx] = newByte;
+                    changedBytes |= 1 << (byteIdx + idx);
+                }
+            }
+        }
+        
+        return changedBytes;
+    }
+    
+    // Read a parameter value from serialized data
+    static uint8_t readField(const uint8_t* data, const ArpeggiatorParam param)
+    {
+        const uint8_t offset = getBitOffset(param);
+        const uint8_t byteIdx = 1 + (offset >> 3);
+        const uint8_t shift = offset & 7;
+        const uint8_t width = getBitWidth(param);
+        
+        uint16_t field = data[byteIdx];
+        if (shift + width > 8)
+        {
+            field |= static_cast<uint16_t>(data[byteIdx + 1]) << 8;
+        }
+        
+        return static_cast<uint8_t>((field >> shift) & ((1U << width) - 1));
+    }
+    
+    // Update dependent state and observers after a parameter has been changed
+    void onParamChange(const ArpeggiatorParam param, const ArpeggiatorParamDescriptor& descriptor)
+    {
+        bool updateClock = descriptor.updateClock;
+        
+        // Smoothed parameters ramp towards the new value in tickSlew()
+        switch (param)
+        {
+            case ArpeggiatorParam::SPEED:
+            updateClock = m_speed.setTarget(getParam(param));
+            break;
+            case ArpeggiatorParam::VELOCITY:
+            m_velocity.setTarget(getParam(param));
+            break;
+            case ArpeggiatorParam::SLEW:
+            updateClock = updateSlewRate();
+            break;
+            default:
+            break;
+        }
+        
+        if (updateClock)
+        {
+            updateBPMClock();
+        }
+        
+        setDirty(param);
+        notify(param);
+    }
+    
+    // Mark a parameter as changed since the last call of serializeDelta() or deserialize()
+    void setDirty(const ArpeggiatorParam param)
+    {
+        // Parameters may be changed from both ISR and main loop context
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            m_dirty = m_dirty | (1U << static_cast<uint8_t>(param));
+        }
+    }
+    
+    // Get and clear the bit mask of changed parameters
+    uint16_t takeDirty()
+    {
+        uint16_t dirty;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            dirty = m_dirty;
+            m_dirty = 0;
+        }
+        return dirty;
+    }
+    
     Subject<ArpeggiatorParam, uint8_t> m_subjectParamUpdate;
     
     void notify(const ArpeggiatorParam param)
     {
-        m_subjectParamUpdate.notifyObserver(param, getParam(param));
+        if (m_deferredNotification)
+        {
+            // Parameters may be changed from both ISR and main loop context
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                m_pendingNotification = m_pendingNotification | (1U << static_cast<uint8_t>(param));
+            }
+        }
+        else
+        {
+            m_subjectParamUpdate.notifyObserver(param, getParam(param));
+        }
     }
+    
+    // Bit mask of parameters with pending observer notification
+    volatile uint16_t m_pendingNotification {0};
+    
+    // Flag indicating deferred observer notification
+    bool m_deferredNotification {false};
 
     // Actual arpeggiator parameters
     Param<uint8_t> m_params[static_cast<uint8_t>(ArpeggiatorParam::NOFENTRIES)];
+    
+    // Smoothed parameters
+    ParamSlew m_speed;
+    ParamSlew m_velocity;
+    
+    // Bit mask of parameters changed since the last call of serializeDelta() or deserialize(). Initially, no image has been saved
+    volatile uint16_t m_dirty {0xFFFF};
 };
 
+static_assert(static_cast<uint8_t>(ArpeggiatorParam::NOFENTRIES) <= 16, "Dirty mask of ArpeggiatorParams is limited to 16 parameters");
+static_assert(ArpeggiatorParams::size() <= 8, "Byte mask of ArpeggiatorParams::serializeDelta() is limited to 8 bytes");
+
 /**
 @brief Arpeggiator class
 */
@@ -304,22 +551,53 @@ public ArpeggiatorParams
         return ArpeggiatorMode::HOLD == getMode();
     }
 
-    // Reset the arpeggiator
+    /**
+    @brief Set the seed of the random generator used by the random pattern
+    @param seed Seed value, the same seed reproduces the same random pattern
+    */
+    constexpr void setRandomSeed(const uint16_t seed)
+    {
+        m_random.setSeed(seed);
+    }
+    
+    // Reset the arpeggiator, e.g. on MIDI start. The next call of clock24PPQN() starts a new step, such that steps are aligned to the clock source
     constexpr void resetCurrentStep()
     {
         m_currentStep = 0;
+        m_currentOctave = 0;
+        m_tick = 0;
     }
     
-    //// Increment 24 ppqn clock
-    //constexpr void clock24PPQN()
-    //{
-    //if (m_clockDivider.clock())
-    //{
-    //clock();
-    //}
-    //}
+    /**
+    @brief Increment 24 ppqn clock
+    The step length is given by the scale parameter, which is applied on the next step.
+    A new note is played on the first tick of every step, the note is released after the fraction of the step given by the gate parameter.
+    Smoothed parameters are advanced on every tick
+    */
+    void clock24PPQN()
+    {
+        tickSlew();
+        
+        if (0 == m_tick)
+        {
+            m_ticksPerStep = getTicksPerStep();
+            clock();
+            m_noteOffTick = getNoteOffTick();
+        }
+        else if (m_noteOffTick == m_tick)
+        {
+            noteOff();
+        }
+        
+        m_tick++;
+        if (m_ticksPerStep == m_tick)
+        {
+            m_tick = 0;
+        }
+    }
 
-    // Increment clock by one step
+    // Increment clock by one step. The gate parameter is ignored, i.e. notes are played legato.
+    // If the arpeggiator is not driven by clock24PPQN(), tickSlew() has to be called periodically
     constexpr void clock()
     {
         // Current note off
@@ -336,8 +614,12 @@ public ArpeggiatorParams
         {
             case ArpeggiatorMode::NORMAL:
             case ArpeggiatorMode::HOLD:
-            m_keys.insert(note);
-            updatePattern();
+            dropReleasedKeys();
+            resizeShuffle();
+            if (m_keys.insert(note))
+            {
+                insertShuffle(findKey(note));
+            }
             break;
             
             default:
@@ -348,21 +630,36 @@ public ArpeggiatorParams
     // Remove a note from arpeggiator
     constexpr void removeNote(const uint8_t note)
     {
-        // Remove note from pattern
-        m_keys.remove(note);
         switch (getMode())
         {
+            case ArpeggiatorMode::HOLD:
+            {
+                // Keep playing the released key until a new key is pressed
+                const uint8_t index = findKey(note);
+                if (index < m_keys.length())
+                {
+                    m_releasedKeys |= 1U << index;
+                }
+            }
+            break;
+            
             case ArpeggiatorMode::NORMAL:
+            // Remove note from pattern
+            removeKey(note);
+            resizeShuffle();
+            
             // Send Note Off
             noteOff(note);
-            
-            updatePattern();
-            
-            // Reset the arpeggiator to avoid glitch
-            resetCurrentStep();
+            if (note == m_currentNote)
+            {
+                m_currentNote = s_noNote;
+            }
             break;
 
             default:
+            // Remove note from pattern
+            removeKey(note);
+            resizeShuffle();
             break;
         }
     }
@@ -375,7 +672,8 @@ public ArpeggiatorParams
         
         // Clear the notes
         m_keys.clear();
-        m_notes.clear();
+        m_releasedKeys = 0;
+        resizeShuffle();
         
         // Reset the arpeggiator to avoid glitch
         resetCurrentStep();
@@ -388,17 +686,35 @@ public ArpeggiatorParams
     // Vector containing the held keys
     VectorSorted<uint8_t, uint8_t, t_maxNofHeldKeys, SortOrder::ASCENDING> m_keys;
     
-    // Vector containing all notes of a pattern
-    static constexpr uint8_t m_maxPatternLength = t_maxNofHeldKeys * 2;
-    Vector<uint8_t, uint8_t, m_maxPatternLength> m_notes {0};
+    // Bit mask of the held keys released in hold mode, which are still played until a new key is pressed. Bit n refers to m_keys[n]
+    uint16_t m_releasedKeys {0};
+    static_assert(t_maxNofHeldKeys <= 16, "Released keys are limited to 16 bits");
     
-    uint8_t m_currentNote {255};
+    // Currently playing note
+    static constexpr uint8_t s_noNote = 255;
+    uint8_t m_currentNote {s_noNote};
 
     // Step inside the pattern
     uint8_t m_currentStep {0};
+    
+    // Octave of the current cycle of the shuffle pattern
+    uint8_t m_currentOctave {0};
+    
+    // Random generator for random and shuffle pattern
+    Xorshift16 m_random;
+    
+    // Permutation of key indices for shuffle pattern. The first m_currentStep entries have already been played in the current cycle
+    uint8_t m_shuffle[t_maxNofHeldKeys] {};
+    uint8_t m_shuffleSize {0};
 
-    // Clock divider for 24 PPQN to 1/32 Note clock --> divide by 3
-    ClockDivider<uint8_t, 3> m_clockDivider;
+    // Number of 24 PPQN ticks of the current step, e.g. 1/32 Note --> 3 ticks per step
+    uint8_t m_ticksPerStep {1};
+    
+    // Tick inside the current step
+    uint8_t m_tick {0};
+    
+    // Tick inside the current step at which the current note is released
+    uint8_t m_noteOffTick {1};
     
     Subject<uint8_t, uint8_t> m_subjectNoteOn;
     Subject<uint8_t> m_subjectNoteOff;
@@ -413,66 +729,230 @@ public ArpeggiatorParams
         return static_cast<ArpeggiatorPattern>(getParam(ArpeggiatorParam::PATTERN));
     }
     
+    [[nodiscard]] constexpr uint8_t getNofOctaves() const
+    {
+        return getParam(ArpeggiatorParam::OCTAVES) + 1;
+    }
+    
+    // Get the number of keys within the octave range, i.e. the held keys repeated once per octave
+    [[nodiscard]] constexpr uint8_t getNofKeys() const
+    {
+        return m_keys.length() * getNofOctaves();
+    }
+    
+    // Transpose a note by the given number of octaves, staying within the MIDI note range
+    [[nodiscard]] static constexpr uint8_t transpose(const uint8_t note, const uint8_t octave)
+    {
+        uint8_t transposedNote = note;
+        for (uint8_t cnt = 0; cnt < octave; ++cnt)
+        {
+            if (transposedNote > 127 - 12)
+            {
+                break;
+            }
+            
+            transposedNote += 12;
+        }
+        
+        return transposedNote;
+    }
+    
+    // Get the note of a key index within the octave range. Key indices beyond the held keys refer to the held keys transposed by one octave per multiple of the number of held keys
+    [[nodiscard]] constexpr uint8_t getNote(uint8_t keyIndex) const
+    {
+        const uint8_t nofHeldKeys = m_keys.length();
+        uint8_t octave = 0;
+        while (keyIndex >= nofHeldKeys)
+        {
+            keyIndex -= nofHeldKeys;
+            ++octave;
+        }
+        
+        return transpose(m_keys[keyIndex], octave);
+    }
+    
     constexpr void noteOn(const uint8_t note) const
     {
-        m_subjectNoteOn.notifyObserver(note, getParam(ArpeggiatorParam::VELOCITY));
+        m_subjectNoteOn.notifyObserver(note, getVelocity());
     }
     
     constexpr void noteOff(const uint8_t note) const
     {
         m_subjectNoteOff.notifyObserver(note);
     }
-    constexpr void noteOff() const
+    constexpr void noteOff()
     {
-        noteOff(m_currentNote);
+        if (s_noNote != m_currentNote)
+        {
+            noteOff(m_currentNote);
+            m_currentNote = s_noNote;
+        }
     }
     
-    constexpr void updatePattern()
+    // Get the number of 24 PPQN ticks per step according to the scale parameter
+    [[nodiscard]] uint8_t getTicksPerStep() const
     {
+        // 1/1 Note --> 96 ticks, each finer scale halves the number of ticks
+        constexpr uint8_t ticksPerWholeNote = 4 * 24;
+        static constexpr const PROGMEM ProgmemTable<uint8_t, static_cast<uint8_t>(Scale::NOFENTRIES)> ticksPerStep(
+        [](const uint16_t scale) {return static_cast<uint8_t>(ticksPerWholeNote >> scale);});
+        
+        return ticksPerStep.getP(getParam(ArpeggiatorParam::SCALE));
+    }
+    
+    // Get the tick inside the current step at which the note is released according to the gate parameter
+    // A result equal to the number of ticks per step means that the note is released on the next step, i.e. legato
+    [[nodiscard]] constexpr uint8_t getNoteOffTick() const
+    {
+        const uint8_t tick = (static_cast<uint16_t>(m_ticksPerStep) * (getParam(ArpeggiatorParam::GATE) + 1)) >> 8;
+        return (0 == tick) ? 1 : tick;
+    }
+    
+    // Find a held key
+    // Returns the number of held keys if the key is not held
+    [[nodiscard]] constexpr uint8_t findKey(const uint8_t note) const
+    {
+        uint8_t index = 0;
+        while (index < m_keys.length() && m_keys[index] != note)
+        {
+            ++index;
+        }
+        return index;
+    }
+    
+    // Remove a held key, keeping the released key flags in step with the key indices
+    constexpr void removeKey(const uint8_t note)
+    {
+        const uint8_t index = findKey(note);
+        if (index >= m_keys.length())
+        {
+            return;
+        }
+        
+        m_keys.remove(note);
+        
+        // Flags above the removed key move down by one
+        const uint16_t lowerKeys = (1U << index) - 1;
+        m_releasedKeys = (m_releasedKeys & lowerKeys) | ((m_releasedKeys >> 1) & ~lowerKeys);
+    }
+    
+    // Remove the keys released in hold mode from the pattern
+    constexpr void dropReleasedKeys()
+    {
+        // Remove from the highest index downwards, so the indices of the remaining flagged keys are not affected
+        for (uint8_t index = m_keys.length(); index-- > 0;)
+        {
+            if (m_releasedKeys & (1U << index))
+            {
+                const uint8_t key = m_keys[index];
+                m_keys.remove(key);
+            }
+        }
+        
+        m_releasedKeys = 0;
+    }
+    
+    // Keep the shuffle permutation consistent with the number of held keys after keys have been removed
+    constexpr void resizeShuffle()
+    {
+        const uint8_t nofKeys = m_keys.length();
+        if (nofKeys < m_shuffleSize)
+        {
+            // Start over with the identity permutation
+            for (m_shuffleSize = 0; m_shuffleSize < nofKeys; ++m_shuffleSize)
+            {
+                m_shuffle[m_shuffleSize] = m_shuffleSize;
+            }
+        }
+    }
+    
+    // Add the key index of an inserted key to the shuffle permutation
+    constexpr void insertShuffle(const uint8_t keyIndex)
+    {
+        // Key indices at and above the inserted key have moved up by one
+        for (uint8_t pos = 0; pos < m_shuffleSize; ++pos)
+        {
+            if (m_shuffle[pos] >= keyIndex)
+            {
+                ++m_shuffle[pos];
+            }
+        }
+        
+        // The added key is appended to the keys not yet played in the current cycle
+        m_shuffle[m_shuffleSize++] = keyIndex;
+    }
+    
+    // Get the number of steps of the current pattern, which is derived from the held keys
+    [[nodiscard]] constexpr uint8_t getNofSteps() const
+    {
+        const uint8_t nofKeys = getNofKeys();
         switch (getPattern())
         {
             case ArpeggiatorPattern::UP:
-            updatePatternUP(m_keys, m_notes);
-            break;
-
+            case ArpeggiatorPattern::RANDOM:
+            return getNofStepsUP(nofKeys);
+            
+            case ArpeggiatorPattern::SHUFFLE:
+            // The shuffle pattern cycles through the held keys once per octave
+            return m_keys.length();
+            
             case ArpeggiatorPattern::DOWN:
-            updatePatternDOWN(m_keys, m_notes);
-            break;
+            return getNofStepsDOWN(nofKeys);
             
             case ArpeggiatorPattern::UPDOWN:
-            updatePatternUPDOWN(m_keys, m_notes);
-            break;
+            return getNofStepsUPDOWN(nofKeys);
             
             case ArpeggiatorPattern::UPDOWN_HOLD:
-            updatePatternUPDOWNNHOLD(m_keys, m_notes);
-            break;
+            return getNofStepsUPDOWNHOLD(nofKeys);
             
-            case ArpeggiatorPattern::RANDOM:
-            updatePatternUP(m_keys, m_notes);
-            break;
-
             default:
-            m_notes.clear();
+            return 0;
         }
-    }    
+    }
+    
+    // Get the index of the held key played at the given step of the current pattern
+    [[nodiscard]] constexpr uint8_t getKeyIndex(const uint8_t step) const
+    {
+        const uint8_t nofKeys = getNofKeys();
+        switch (getPattern())
+        {
+            case ArpeggiatorPattern::DOWN:
+            return getKeyIndexDOWN(step, nofKeys);
+            
+            case ArpeggiatorPattern::UPDOWN:
+            return getKeyIndexUPDOWN(step, nofKeys);
+            
+            case ArpeggiatorPattern::UPDOWN_HOLD:
+            return getKeyIndexUPDOWNHOLD(step, nofKeys);
+            
+            default:
+            return getKeyIndexUP(step, nofKeys);
+        }
+    }
     
     // Set the note which is played next according to pattern
     constexpr void playNextNote()
     {
-        const uint8_t nofSteps = m_notes.length();
+        const uint8_t nofSteps = getNofSteps();
         if (0 == nofSteps)
         {
             m_currentStep = 0;
             return;
         }
         
+        // The number of steps may have changed since the last step due to released keys or a pattern change
+        if (m_currentStep >= nofSteps)
+        {
+            m_currentStep = 0;
+        }
+        
         switch (getPattern())
         {
             case ArpeggiatorPattern::UP:
             case ArpeggiatorPattern::DOWN:
             case ArpeggiatorPattern::UPDOWN:
             case ArpeggiatorPattern::UPDOWN_HOLD:
-            noteOn(m_currentNote = m_notes[m_currentStep]);
+            noteOn(m_currentNote = getNote(getKeyIndex(m_currentStep)));
             m_currentStep++;
             if (nofSteps == m_currentStep)
             {
@@ -482,8 +962,31 @@ public ArpeggiatorParams
             
             case ArpeggiatorPattern::RANDOM:
             {
-                const uint8_t note = static_cast<uint8_t>(rand()) % m_notes.length();
-                noteOn(m_currentNote = m_notes[note]);
+                const uint8_t keyIndex = m_random.next(nofSteps);
+                noteOn(m_currentNote = getNote(keyIndex));
+            }
+            break;
+            
+            case ArpeggiatorPattern::SHUFFLE:
+            {
+                // Pick one of the keys not yet played in the current cycle, i.e. one step of a Fisher-Yates shuffle
+                const uint8_t pick = m_currentStep + m_random.next(nofSteps - m_currentStep);
+                const uint8_t keyIndex = m_shuffle[pick];
+                m_shuffle[pick] = m_shuffle[m_currentStep];
+                m_shuffle[m_currentStep] = keyIndex;
+                noteOn(m_currentNote = transpose(m_keys[keyIndex], m_currentOctave));
+                
+                m_currentStep++;
+                if (nofSteps == m_currentStep)
+                {
+                    // Next cycle is played one octave higher
+                    m_currentStep = 0;
+                    m_currentOctave++;
+                    if (m_currentOctave >= getNofOctaves())
+                    {
+                        m_currentOctave = 0;
+                    }
+                }
             }
             break;
             
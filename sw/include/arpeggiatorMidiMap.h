@@ -0,0 +1,341 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ARPEGGIATOR_MIDI_MAP_H
+#define ARPEGGIATOR_MIDI_MAP_H
+
+#include "arpeggiator.h"
+#include "midi_types.h"
+#include <stdint.h>
+
+/**
+@brief Mapping of MIDI control change and NRPN messages to arpeggiator parameters
+Incoming control changes are dispatched to ArpeggiatorParams::setParam() using a lookup table indexed by the controller number.
+All parameters are also accessible by NRPN with 14-bit resolution, wherein the NRPN LSB is the parameter index and the NRPN MSB is a selectable bank.
+Parameter changes from other sources are echoed to the MIDI output as control changes of the mapped controller.
+This class can be used as sink of MidiInput::parse()
+@tparam MidiOut MIDI output class implementing static method writeControlChange(MidiChannel, uint8_t, uint8_t), e.g. MidiOutput
+*/
+template <typename MidiOut>
+class ArpeggiatorMidiMap
+{
+    public:
+    
+    /**
+    @brief Constructor
+    @param params Arpeggiator parameters to be controlled
+    */
+    constexpr ArpeggiatorMidiMap(ArpeggiatorParams& params)
+    :
+    m_params(params)
+    {
+        for (uint8_t idx = 0; idx < 128; ++idx)
+        {
+            m_controllerToParam[idx] = s_unmapped;
+        }
+        
+        for (uint8_t idx = 0; idx < s_nofParams; ++idx)
+        {
+            m_paramToController[idx] = s_unmapped;
+            m_echoValue[idx] = params.getParam(static_cast<ArpeggiatorParam>(idx));
+        }
+    }
+    
+    /**
+    @brief Set the MIDI channel used for input and echo
+    @param channel MIDI channel
+    */
+    constexpr void setChannel(const MidiChannel channel)
+    {
+        m_channel = channel;
+    }
+    
+    /**
+    @brief Set the NRPN bank, i.e. the NRPN MSB addressing the arpeggiator parameters
+    @param bank NRPN MSB 0..127
+    */
+    constexpr void setNrpnBank(const uint8_t bank)
+    {
+        m_nrpnBank = bank;
+    }
+    
+    /**
+    @brief Map a controller to a parameter. Previous mappings of both the controller and the parameter are removed
+    @param controller MIDI controller number 0..127. Controllers reserved for (N)RPN, data entry and channel mode messages cannot be mapped
+    @param param Arpeggiator parameter
+    */
+    constexpr void setMapping(const uint8_t controller, const ArpeggiatorParam param)
+    {
+        if (controller > 127 || isReserved(controller))
+        {
+            return;
+        }
+        
+        clearMapping(param);
+        clearMapping(controller);
+        m_controllerToParam[controller] = static_cast<uint8_t>(param);
+        m_paramToController[static_cast<uint8_t>(param)] = controller;
+    }
+    
+    /**
+    @brief Remove the mapping of a controller
+    @param controller MIDI controller number 0..127
+    */
+    constexpr void clearMapping(const uint8_t controller)
+    {
+        const uint8_t param = m_controllerToParam[controller];
+        if (s_unmapped != param)
+        {
+            m_paramToController[param] = s_unmapped;
+            m_controllerToParam[controller] = s_unmapped;
+        }
+    }
+    
+    /**
+    @brief Remove the mapping of a parameter
+    @param param Arpeggiator parameter
+    */
+    constexpr void clearMapping(const ArpeggiatorParam param)
+    {
+        const uint8_t controller = m_paramToController[static_cast<uint8_t>(param)];
+        if (s_unmapped != controller)
+        {
+            m_controllerToParam[controller] = s_unmapped;
+            m_paramToController[static_cast<uint8_t>(param)] = s_unmapped;
+        }
+    }
+    
+    /**
+    @brief Get the controller mapped to a parameter
+    @param param Arpeggiator parameter
+    @result MIDI controller number, or a value > 127 if the parameter is not mapped
+    */
+    [[nodiscard]] constexpr uint8_t getController(const ArpeggiatorParam param) const
+    {
+        return m_paramToController[static_cast<uint8_t>(param)];
+    }
+    
+    /**
+    @brief Start learn mode. The next incoming control change is mapped to the given parameter
+    @param param Arpeggiator parameter
+    */
+    constexpr void startLearn(const ArpeggiatorParam param)
+    {
+        m_learnParam = static_cast<uint8_t>(param);
+    }
+    
+    /**
+    @brief Stop learn mode without changing the mapping
+    */
+    constexpr void stopLearn()
+    {
+        m_learnParam = s_unmapped;
+    }
+    
+    /**
+    @brief Check for active learn mode
+    */
+    [[nodiscard]] constexpr bool isLearning() const
+    {
+        return s_unmapped != m_learnParam;
+    }
+    
+    /**
+    @brief Callback for incoming MIDI control change messages
+    @param message MIDI control change message
+    */
+    void operator()(const MidiControlChange& message)
+    {
+        if (message.status.channel != m_channel)
+        {
+            return;
+        }
+        
+        const uint8_t controller = message.controller;
+        const uint8_t value = message.value;
+        
+        switch (controller)
+        {
+            case s_ccNrpnMsb:
+            m_nrpnMsb = value;
+            return;
+            
+            case s_ccNrpnLsb:
+            m_nrpnLsb = value;
+            return;
+            
+            case s_ccRpnMsb:
+            case s_ccRpnLsb:
+            // RPN selection deselects the current NRPN
+            m_nrpnMsb = s_unmapped;
+            return;
+            
+            case s_ccDataEntryMsb:
+            m_dataMsb = value;
+            onNrpn(static_cast<uint16_t>(value) << 7);
+            return;
+            
+            case s_ccDataEntryLsb:
+            onNrpn((static_cast<uint16_t>(m_dataMsb) << 7) | value);
+            return;
+            
+            default:
+            break;
+        }
+        
+        // Channel mode messages, e.g. All Notes Off sent on transport stop, neither control parameters nor end learn mode
+        if (isReserved(controller))
+        {
+            return;
+        }
+        
+        if (isLearning())
+        {
+            setMapping(controller, static_cast<ArpeggiatorParam>(m_learnParam));
+            stopLearn();
+        }
+        
+        const uint8_t param = m_controllerToParam[controller];
+        if (s_unmapped != param)
+        {
+            // Extend 7-bit controller value to 14 bits by bit replication, such that 127 yields the maximum parameter value
+            setParam(static_cast<ArpeggiatorParam>(param), (static_cast<uint16_t>(value) << 7) | value);
+        }
+    }
+    
+    /**
+    @brief Callback for all other incoming MIDI messages, which are ignored
+    */
+    template <typename Message>
+    constexpr void operator()(const Message& /*message*/)
+    {}
+    
+    /**
+    @brief Callback for parameter changes, to be registered as observer of ArpeggiatorParams
+    Changes of mapped parameters are echoed as control change, unless the change has been received from MIDI input
+    @param param Arpeggiator parameter
+    @param value New parameter value
+    */
+    void onParamChange(const ArpeggiatorParam param, const uint8_t value)
+    {
+        const uint8_t idx = static_cast<uint8_t>(param);
+        if (value == m_echoValue[idx])
+        {
+            return;
+        }
+        
+        m_echoValue[idx] = value;
+        
+        const uint8_t controller = m_paramToController[idx];
+        if (s_unmapped != controller)
+        {
+            // Send the smallest controller value which maps back to the parameter value, i.e. the inverse of the bit-replicated scaling in setParam().
+            // For parameter ranges of up to 128 values, this mapping is lossless
+            const ArpeggiatorParamDescriptor descriptor = getParamDescriptorP(param);
+            const uint32_t range = (static_cast<uint32_t>(descriptor.max - descriptor.min) + 1) * 129;
+            const uint8_t controllerValue = static_cast<uint8_t>(((static_cast<uint32_t>(value - descriptor.min) << 14) + range - 1) / range);
+            MidiOut::writeControlChange(m_channel, controller, controllerValue);
+        }
+    }
+    
+    private:
+    
+    // Apply NRPN data entry to the selected parameter
+    void onNrpn(const uint16_t value)
+    {
+        if (m_nrpnMsb == m_nrpnBank && m_nrpnLsb < s_nofParams)
+        {
+            setParam(static_cast<ArpeggiatorParam>(m_nrpnLsb), value);
+        }
+    }
+    
+    // Scale a 14-bit MIDI value to the parameter range and set the parameter.
+    // The resulting parameter value is not echoed
+    void setParam(const ArpeggiatorParam param, const uint16_t value)
+    {
+        const ArpeggiatorParamDescriptor descriptor = getParamDescriptorP(param);
+        const uint16_t range = static_cast<uint16_t>(descriptor.max - descriptor.min) + 1;
+        const uint8_t paramValue = descriptor.min + static_cast<uint8_t>((static_cast<uint32_t>(value) * range) >> 14);
+        
+        m_echoValue[static_cast<uint8_t>(param)] = paramValue;
+        m_params.setParam(param, paramValue);
+    }
+    
+    // Check for controllers reserved for (N)RPN, data entry and channel mode messages
+    static constexpr bool isReserved(const uint8_t controller)
+    {
+        if (controller >= s_ccChannelModeFirst)
+        {
+            return true;
+        }
+        
+        switch (controller)
+        {
+            case s_ccDataEntryMsb:
+            case s_ccDataEntryLsb:
+            case s_ccNrpnLsb:
+            case s_ccNrpnMsb:
+            case s_ccRpnLsb:
+            case s_ccRpnMsb:
+            return true;
+            default:
+            return false;
+        }
+    }
+    
+    static constexpr uint8_t s_nofParams = static_cast<uint8_t>(ArpeggiatorParam::NOFENTRIES);
+    
+    // Marker for unmapped controllers and parameters
+    static constexpr uint8_t s_unmapped = 0xFF;
+    
+    // Controller numbers for (N)RPN and data entry
+    static constexpr uint8_t s_ccDataEntryMsb = 6;
+    static constexpr uint8_t s_ccDataEntryLsb = 38;
+    static constexpr uint8_t s_ccNrpnLsb = 98;
+    static constexpr uint8_t s_ccNrpnMsb = 99;
+    static constexpr uint8_t s_ccRpnLsb = 100;
+    static constexpr uint8_t s_ccRpnMsb = 101;
+    
+    // Controller numbers 120..127 are channel mode messages
+    static constexpr uint8_t s_ccChannelModeFirst = 120;
+    
+    // Controlled arpeggiator parameters
+    ArpeggiatorParams& m_params;
+    
+    // Controller to parameter mapping
+    uint8_t m_controllerToParam[128];
+    
+    // Parameter to controller mapping
+    uint8_t m_paramToController[s_nofParams];
+    
+    // Last parameter values received or sent, used for echo suppression
+    uint8_t m_echoValue[s_nofParams];
+    
+    // MIDI channel used for input and echo
+    MidiChannel m_channel = MidiChannel::_1;
+    
+    // Parameter to be mapped in learn mode
+    uint8_t m_learnParam = s_unmapped;
+    
+    // NRPN state
+    uint8_t m_nrpnBank = 0;
+    uint8_t m_nrpnMsb = s_unmapped;
+    uint8_t m_nrpnLsb = s_unmapped;
+    uint8_t m_dataMsb = 0;
+};
+
+#endif
@@ -19,7 +19,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #define ARPEGGIATOR_PARAM_TYPES_H
 
 #include "ArpeggiatorParam_enums.h"
-#include "lookup_table.h"
+#include "progmem_table.h"
 #include <stdint.h>
 
 enum class ArpeggiatorParamType : uint8_t
@@ -29,57 +29,142 @@ enum class ArpeggiatorParamType : uint8_t
     PATTERN,
     BPM,
     SCALE,
+    OCTAVES,
     NOFENTRIES
 };
 
-// Assign parameter type to parameter indices using a lookup-table stored in progmem.
-// Default value is "no type", i.e. a bare unsigned char
-inline ArpeggiatorParamType getParamType(const ArpeggiatorParam param)
+/**
+@brief Descriptor of an arpeggiator parameter
+*/
+struct ArpeggiatorParamDescriptor
 {
-    typedef SparseLUT<ArpeggiatorParamType, uint8_t, static_cast<uint8_t>(ArpeggiatorParam::NOFENTRIES)>::Entry Entry;
+    ArpeggiatorParamType type;
+    uint8_t min;
+    uint8_t max;
+    uint8_t defaultValue;
+    bool updateClock; // Parameter affects the BPM clock
+};
 
-    constexpr static const PROGMEM SparseLUT<ArpeggiatorParamType, uint8_t, static_cast<uint8_t>(ArpeggiatorParam::NOFENTRIES)> paramType(
-    ArpeggiatorParamType::NONE,
-    Entry{static_cast<uint8_t>(ArpeggiatorParam::MODE), ArpeggiatorParamType::MODE},
-    Entry{static_cast<uint8_t>(ArpeggiatorParam::PATTERN), ArpeggiatorParamType::PATTERN},
-    Entry{static_cast<uint8_t>(ArpeggiatorParam::SPEED), ArpeggiatorParamType::BPM},
-    Entry{static_cast<uint8_t>(ArpeggiatorParam::SCALE), ArpeggiatorParamType::SCALE}
-    );
+// Declaration of all arpeggiator parameters, evaluated at compile time.
+// Parameters without specific type are bare unsigned chars with full range
+constexpr ArpeggiatorParamDescriptor getParamDescriptor(const uint16_t param)
+{
+    switch (static_cast<ArpeggiatorParam>(param))
+    {
+        case ArpeggiatorParam::MODE:
+        return {ArpeggiatorParamType::MODE, 0, static_cast<uint8_t>(ArpeggiatorMode::MAX), static_cast<uint8_t>(ArpeggiatorMode::OFF), false};
+        
+        case ArpeggiatorParam::SPEED:
+        // The BPM clock is updated by the slew engine once the smoothed speed changes
+        return {ArpeggiatorParamType::BPM, 0, 255, 0, false};
+        
+        case ArpeggiatorParam::PATTERN:
+        return {ArpeggiatorParamType::PATTERN, 0, static_cast<uint8_t>(ArpeggiatorPattern::MAX), static_cast<uint8_t>(ArpeggiatorPattern::UP), false};
+        
+        case ArpeggiatorParam::SCALE:
+        return {ArpeggiatorParamType::SCALE, 0, static_cast<uint8_t>(Scale::MAX), static_cast<uint8_t>(Scale::_1_4), true};
+        
+        case ArpeggiatorParam::VELOCITY:
+        return {ArpeggiatorParamType::NONE, 0, 255, 127, false};
+        
+        case ArpeggiatorParam::BAR_LENGTH:
+        // Not evaluated by the arpeggiator, stored for the application
+        return {ArpeggiatorParamType::NONE, 0, 255, 0, false};
+        
+        case ArpeggiatorParam::OCTAVES:
+        return {ArpeggiatorParamType::OCTAVES, 0, static_cast<uint8_t>(ArpeggiatorOctaves::MAX), static_cast<uint8_t>(ArpeggiatorOctaves::_1), false};
+        
+        case ArpeggiatorParam::GATE:
+        return {ArpeggiatorParamType::NONE, 0, 255, 127, false};
+        
+        case ArpeggiatorParam::SLEW:
+        // 0 disables smoothing of SPEED and VELOCITY
+        return {ArpeggiatorParamType::NONE, 0, 255, 0, false};
+        
+        default:
+        return {ArpeggiatorParamType::NONE, 0, 255, 0, false};
+    }
+}
 
-    return paramType.getP(static_cast<uint8_t>(param));
+// Read the descriptor of a parameter from a dense lookup table stored in progmem
+inline ArpeggiatorParamDescriptor getParamDescriptorP(const ArpeggiatorParam param)
+{
+    static constexpr const PROGMEM ProgmemTable<ArpeggiatorParamDescriptor, static_cast<uint8_t>(ArpeggiatorParam::NOFENTRIES)> paramDescriptor(getParamDescriptor);
+    
+    return paramDescriptor.getP(static_cast<uint8_t>(param));
 }
 
+// Get the type of a parameter
+inline ArpeggiatorParamType getParamType(const ArpeggiatorParam param)
+{
+    return getParamDescriptorP(param).type;
+}
 
+// Get the min value of a parameter
+inline uint8_t getMinValue(const ArpeggiatorParam param)
+{
+    return getParamDescriptorP(param).min;
+}
 
-// Assign min value to parameter types using a lookup-table stored in progmem.
-// Default value is 0
-inline uint8_t getMinValue(const ArpeggiatorParamType /*patchParamType*/)
+// Get the max value of a parameter
+inline uint8_t getMaxValue(const ArpeggiatorParam param)
 {
-    //static const PROGMEM SparseLUT<uint8_t, uint8_t, static_cast<uint8_t>(ArpeggiatorParamType::NOFENTRIES)> LUT(
-    //0);
-    //
-    //return LUT.getP(static_cast<uint8_t>(patchParamType));
-    
-    return 0;
+    return getParamDescriptorP(param).max;
 }
 
-// Assign max value to parameter types using a lookup-table stored in progmem.
-// Default value is 255
-inline uint8_t getMaxValue(const ArpeggiatorParamType paramType)
+// Get a parameter of the given type, which represents the value range of this type
+constexpr ArpeggiatorParam getParamOfType(const ArpeggiatorParamType paramType)
 {
-    typedef SparseLUT<uint8_t, uint8_t, static_cast<uint8_t>(ArpeggiatorParamType::NOFENTRIES)>::Entry Entry;
+    switch (paramType)
+    {
+        case ArpeggiatorParamType::MODE:
+        return ArpeggiatorParam::MODE;
+        
+        case ArpeggiatorParamType::PATTERN:
+        return ArpeggiatorParam::PATTERN;
+        
+        case ArpeggiatorParamType::BPM:
+        return ArpeggiatorParam::SPEED;
+        
+        case ArpeggiatorParamType::SCALE:
+        return ArpeggiatorParam::SCALE;
+        
+        case ArpeggiatorParamType::OCTAVES:
+        return ArpeggiatorParam::OCTAVES;
+        
+        default:
+        return ArpeggiatorParam::VELOCITY;
+    }
+}
 
-    static const PROGMEM SparseLUT<uint8_t, uint8_t, static_cast<uint8_t>(ArpeggiatorParamType::NOFENTRIES)> LUT(
-    255,
-    Entry{static_cast<uint8_t>(ArpeggiatorParamType::MODE), static_cast<uint8_t>(ArpeggiatorMode::MAX)},
-    Entry{static_cast<uint8_t>(ArpeggiatorParamType::PATTERN), static_cast<uint8_t>(ArpeggiatorPattern::MAX)},
-    Entry{static_cast<uint8_t>(ArpeggiatorParamType::SCALE), static_cast<uint8_t>(Scale::MAX)});
+// All parameters of a type share the value range of the representative parameter
+constexpr bool hasConsistentTypeLimits()
+{
+    for (uint8_t idx = 0; idx < static_cast<uint8_t>(ArpeggiatorParam::NOFENTRIES); ++idx)
+    {
+        const ArpeggiatorParamDescriptor descriptor = getParamDescriptor(idx);
+        const ArpeggiatorParamDescriptor typeDescriptor = getParamDescriptor(static_cast<uint8_t>(getParamOfType(descriptor.type)));
+        if (descriptor.min != typeDescriptor.min || descriptor.max != typeDescriptor.max)
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+static_assert(hasConsistentTypeLimits(), "Parameters of the same type have to share the same value range");
 
-    return LUT.getP(static_cast<uint8_t>(paramType));
+// Get the min value of a parameter type, e.g. for generic parameter editors
+inline uint8_t getMinValue(const ArpeggiatorParamType paramType)
+{
+    return getMinValue(getParamOfType(paramType));
 }
-    
-    
-    
 
+// Get the max value of a parameter type, e.g. for generic parameter editors
+inline uint8_t getMaxValue(const ArpeggiatorParamType paramType)
+{
+    return getMaxValue(getParamOfType(paramType));
+}
 
 #endif
\ No newline at end of file
@@ -29,6 +29,9 @@ enum class ArpeggiatorParam : uint8_t
     SCALE,
     VELOCITY,
     BAR_LENGTH,
+    OCTAVES,
+    GATE, // Note length as fraction of a step, 255 = legato
+    SLEW, // Smoothing of SPEED and VELOCITY changes, 0 = off
     NOFENTRIES
 };
 
@@ -87,6 +90,7 @@ enum class ArpeggiatorPattern : uint8_t
     UPDOWN,
     UPDOWN_HOLD,
     RANDOM,
+    SHUFFLE, // Every held key is played once per cycle in random order
     NOFENTRIES,
     MIN = UP,
     MAX = NOFENTRIES-1
@@ -176,4 +180,51 @@ struct numeric_limits <Scale>
     }
 };
 
+/// @brief Octave range of the arpeggio
+enum class ArpeggiatorOctaves : uint8_t
+{
+    _1 = 0, // Held keys only
+    _2, // Held keys and held keys transposed by one octave
+    _3,
+    _4,
+    NOFENTRIES,
+    MIN = 0,
+    MAX = NOFENTRIES-1
+};
+
+inline ArpeggiatorOctaves& operator++(ArpeggiatorOctaves & arg)
+{
+    return arg = static_cast<ArpeggiatorOctaves>(static_cast<uint8_t>(arg)+1);
+}
+
+inline ArpeggiatorOctaves& operator--(ArpeggiatorOctaves & arg)
+{
+    return arg = static_cast<ArpeggiatorOctaves>(static_cast<uint8_t>(arg)-1);
+}
+
+/**
+@brief Numeric limits of ArpeggiatorOctaves
+*/
+template <>
+struct numeric_limits <ArpeggiatorOctaves>
+{
+    /**
+    @brief Maximum value
+    @result Maximum value of ArpeggiatorOctaves
+    */
+    static constexpr ArpeggiatorOctaves max()
+    {
+        return ArpeggiatorOctaves::MAX;
+    }
+    
+    /**
+    @brief Minimum value
+    @result Minimum value of ArpeggiatorOctaves
+    */
+    static constexpr ArpeggiatorOctaves min()
+    {
+        return ArpeggiatorOctaves::MIN;
+    }
+};
+
 #endif
\ No newline at end of file
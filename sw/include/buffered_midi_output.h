@@ -0,0 +1,208 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef BUFFERED_MIDI_OUTPUT_H
+#define BUFFERED_MIDI_OUTPUT_H
+
+#include <stdint.h>
+#include "midi_output.h"
+
+/**
+@brief Lock-free single-producer single-consumer transmit buffer to be used as output driver of MidiOutput
+Bytes are queued by put() and drained by onTxEmpty(), which has to be called from the TX data register empty interrupt of the output driver.
+put() never waits, as it may be called from an ISR which cannot be preempted by the TX interrupt. If the buffer is full, the byte is dropped.
+After a dropped byte, all bytes up to the next status byte are dropped as well, such that the receiver never sees data bytes of a truncated message attached to another status.
+Real-time bytes, e.g. forwarded timing clocks, are still queued in between if there is room
+@tparam Output Output driver class implementing static methods put(uint8_t), enableTxInterrupt() and disableTxInterrupt(), e.g. USART
+@tparam t_bufferSize Size of the buffer in bytes, has to be a power of two. The buffer holds up to t_bufferSize-1 bytes
+*/
+template <typename Output, uint8_t t_bufferSize>
+class MidiTxBuffer
+{
+    static_assert(t_bufferSize >= 2 && 0 == (t_bufferSize & (t_bufferSize - 1)), "Buffer size has to be a power of two");
+    
+    public:
+    
+    /**
+    @brief Queue one byte for transmission without waiting
+    @param byte Byte to be transmitted
+    @result true if the byte has been queued, false if it has been dropped
+    */
+    static bool put(const uint8_t byte)
+    {
+        // Real-time bytes may be interleaved with any message, so they are queued if there is room, but never affect resynchronization
+        const bool realTime = byte >= 0xF8;
+        if (s_dropping && !realTime)
+        {
+            // Resynchronize on the next channel or system common status byte
+            if (byte < 0x80)
+            {
+                return false;
+            }
+            s_dropping = false;
+        }
+        
+        const uint8_t head = s_head;
+        const uint8_t nextHead = (head + 1) & s_indexMask;
+        if (nextHead == s_tail)
+        {
+            // A dropped real-time byte does not truncate a message
+            if (!realTime)
+            {
+                s_dropping = true;
+            }
+            s_overflow = true;
+            return false;
+        }
+        
+        // The buffer is volatile, so the byte is stored before the write index is published
+        s_buffer[head] = byte;
+        s_head = nextHead;
+        Output::enableTxInterrupt();
+        return true;
+    }
+    
+    /**
+    @brief Check if bytes are dropped until the next status byte
+    MidiOutput sends the next status byte even if running status would omit it
+    */
+    static bool isDropping()
+    {
+        return s_dropping;
+    }
+    
+    /**
+    @brief Check for dropped bytes and reset the overflow flag
+    @result true if bytes have been dropped since the last call
+    */
+    static bool overflow()
+    {
+        const bool overflow = s_overflow;
+        s_overflow = false;
+        return overflow;
+    }
+    
+    /**
+    @brief Callback for TX data register empty interrupt, transmits the next queued byte
+    */
+    static void onTxEmpty()
+    {
+        const uint8_t tail = s_tail;
+        if (tail == s_head)
+        {
+            // Nothing left to transmit
+            Output::disableTxInterrupt();
+            return;
+        }
+        
+        Output::put(s_buffer[tail]);
+        s_tail = (tail + 1) & s_indexMask;
+    }
+    
+    /**
+    @brief Get the number of queued bytes
+    @result Number of bytes not yet transmitted
+    */
+    static uint8_t pending()
+    {
+        return (s_head - s_tail) & s_indexMask;
+    }
+    
+    /**
+    @brief Wait until all queued bytes have been transmitted
+    This must only be called from the main loop with interrupts enabled. Called from an ISR, it would wait forever for the TX interrupt
+    */
+    static void flush()
+    {
+        while (s_head != s_tail)
+        {
+        }
+    }
+    
+    private:
+    
+    static constexpr uint8_t s_indexMask = t_bufferSize - 1;
+    
+    static inline volatile uint8_t s_buffer[t_bufferSize] = {};
+    
+    // Flag indicating that bytes are dropped until the next status byte, only modified by put()
+    static inline volatile bool s_dropping = false;
+    
+    // Flag indicating dropped bytes since the last call of overflow()
+    static inline volatile bool s_overflow = false;
+    
+    // Write index, only modified by put()
+    static inline volatile uint8_t s_head = 0;
+    
+    // Read index, only modified by onTxEmpty()
+    static inline volatile uint8_t s_tail = 0;
+};
+
+/**
+@brief MIDI output interface queueing MIDI messages into a transmit buffer using running status
+Writing a MIDI message never waits for the output. Messages which do not fit into the transmit buffer are dropped, see MidiTxBuffer.
+Dropped note off messages leave notes hanging on the receiver. Hence, the buffer has to hold the worst-case burst of the application, e.g. all note offs and note ons of one arpeggiator step,
+or overflow() has to be checked and handled, e.g. by sending All Notes Off.
+All messages have to be written from the same context, e.g. either from the main loop or from one ISR
+@tparam Output Output driver class implementing static methods put(uint8_t), enableTxInterrupt() and disableTxInterrupt(), e.g. USART
+@tparam t_bufferSize Size of the transmit buffer in bytes, has to be a power of two
+@tparam t_statusRefreshInterval Number of messages after which an unchanged status byte is sent again, 0 disables the refresh
+*/
+template <typename Output, uint8_t t_bufferSize = 32, uint8_t t_statusRefreshInterval = 0>
+class BufferedMidiOutput : public MidiOutput<MidiTxBuffer<Output, t_bufferSize>, true, t_statusRefreshInterval>
+{
+    using Buffer = MidiTxBuffer<Output, t_bufferSize>;
+    
+    public:
+    
+    /**
+    @brief Callback for TX data register empty interrupt of the output driver
+    */
+    static void onTxEmpty()
+    {
+        Buffer::onTxEmpty();
+    }
+    
+    /**
+    @brief Get the number of queued bytes
+    @result Number of bytes not yet transmitted
+    */
+    static uint8_t pending()
+    {
+        return Buffer::pending();
+    }
+    
+    /**
+    @brief Check for dropped messages and reset the overflow flag
+    @result true if messages have been dropped since the last call
+    */
+    static bool overflow()
+    {
+        return Buffer::overflow();
+    }
+    
+    /**
+    @brief Wait until all queued bytes have been transmitted
+    This must only be called from the main loop with interrupts enabled
+    */
+    static void flush()
+    {
+        Buffer::flush();
+    }
+};
+
+#endif
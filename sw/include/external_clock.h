@@ -24,21 +24,134 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "type_traits.h"
 #include <stdint.h>
 
-
-class ExternalClock : Subject<void>
+/**
+@brief External MIDI clock
+Received MIDI timing clock messages are either forwarded directly by clock(), or passed through a jitter filter by clock(timestamp) and regenerated by update().
+The jitter filter is a software PLL tracking phase and period of the received clock (alpha-beta filter), which only uses additions and shifts.
+The regenerated clock events lag the received ones by half a clock period, so reception jitter up to this amount is removed.
+The regenerated clock can be multiplied, i.e. additional clock events are interpolated evenly between the received ones.
+Timestamps are taken from a free-running 16bit timer. The clock period at the slowest tempo has to fit into 16 bits, which limits the timestamp rate to about 1.18MHz at 45 bpm.
+clock(timestamp) and update() share the pending clock events without atomic access, so both have to be called from ISR context, e.g. from the USART RX interrupt and a timer interrupt
+@tparam t_timestampRate Rate of the timestamps passed to clock(timestamp) and update() in Hz, e.g. 250kHz for a 16MHz timer with prescaler 64
+*/
+template <uint32_t t_timestampRate = 250000UL>
+class ExternalClock : public Subject<void>
 {
+    // One period of the received 24 ppqn clock at 45 bpm has to fit into the 16bit timestamps.
+    // This also keeps the scaled rate for the bpm measurement below 2^32
+    static_assert(t_timestampRate > 0 && (t_timestampRate * 60ULL) / (45 * 24) <= 0xFFFF, "Timestamp rate is too high for 16bit timestamps at 45 bpm");
+    
     public:
     
+    /**
+    @brief Callback for received MIDI timing clock message, clock event is forwarded directly
+    */
     constexpr void clock()
     {
         notifyObserver();
     }
     
+    /**
+    @brief Callback for received MIDI timing clock message, clock event is passed through the jitter filter
+    This has to be called from ISR context, as it shares state with update()
+    @param timestamp Reception time of the MIDI timing clock message
+    */
+    constexpr void clock(const uint16_t timestamp)
+    {
+        switch (m_lockState)
+        {
+            case LockState::UNLOCKED:
+            m_phase = timestamp;
+            m_lockState = LockState::PHASE_LOCKED;
+            scheduleTicks(timestamp);
+            break;
+            
+            case LockState::PHASE_LOCKED:
+            lock(timestamp);
+            break;
+            
+            default:
+            {
+                // Prediction error of the reception time
+                const uint16_t period = getPeriod();
+                const uint16_t predictedPhase = m_phase + period;
+                const int16_t error = static_cast<int16_t>(timestamp - predictedPhase);
+                
+                // Lock is lost if the error exceeds half a period, e.g. on tempo jumps
+                const int16_t maxError = period >> 1;
+                if (error > maxError || error < -maxError)
+                {
+                    lock(timestamp);
+                    break;
+                }
+                
+                // Update phase and period estimates
+                m_phase = predictedPhase + (error >> s_phaseFilterShift);
+                m_period += static_cast<int32_t>(error) << (8 - s_periodFilterShift);
+                scheduleTicks(m_phase + (period >> 1));
+            }
+            break;
+        }
+        
+        m_lastTimestamp = timestamp;
+        updateBpm();
+    }
+    
+    /**
+    @brief Trigger the filtered clock events, to be called periodically, e.g. from a timer interrupt
+    The resolution of the regenerated clock is given by the rate of calls
+    This has to be called from ISR context, as it shares state with clock(timestamp)
+    @param now Current time, using the same timer as the timestamps passed to clock(timestamp)
+    */
+    constexpr void update(const uint16_t now)
+    {
+        if (0 != m_nofPendingTicks && static_cast<int16_t>(now - m_nextTick) >= 0)
+        {
+            m_nofPendingTicks--;
+            m_nextTick += getPeriod() >> getMultiplierShift();
+            notifyObserver();
+        }
+    }
+    
+    /**
+    @brief Reset the jitter filter, e.g. on MIDI start or stop messages
+    */
+    constexpr void reset()
+    {
+        m_lockState = LockState::UNLOCKED;
+        m_nofPendingTicks = 0;
+        m_bpmCounter = 0;
+    }
+    
+    /**
+    @brief Get the bpm value measured by the jitter filter, which is updated once per quarter note
+    @result BPM value, 0 if not measured yet
+    */
+    constexpr uint16_t getBpm() const
+    {
+        return m_bpm;
+    }
+    
+    /**
+    @brief Get the clock divider for dividing the directly forwarded clock of clock() down to 16th notes
+    The clock multiplier does not apply to this clock, see getFilteredClockDivider()
+    @result Clock divider
+    */
     constexpr uint8_t getClockDivider()
     {
         return s_baseClockDivider << static_cast<uint8_t>(m_ppqn.getValue());
     }
     
+    /**
+    @brief Get the clock divider for dividing the regenerated clock of clock(timestamp) and update() down to 16th notes
+    Other than getClockDivider(), this includes the clock multiplier
+    @result Clock divider
+    */
+    constexpr uint8_t getFilteredClockDivider() const
+    {
+        return s_baseClockDivider << (static_cast<uint8_t>(m_ppqn.getValue()) + getMultiplierShift());
+    }
+    
     // This has to go below the definition of numeric_limits <ExternalClock::Ppqn>
     constexpr Ppqn incPpqn()
     {
@@ -50,12 +163,114 @@ class ExternalClock : Subject<void>
     {
         return m_ppqn.decrement();
     }
+    
+    /**
+    @brief Increment multiplier of the regenerated clock
+    @result New clock multiplier
+    */
+    constexpr ClockMultiplier incMultiplier()
+    {
+        return m_multiplier.increment();
+    }
+    
+    /**
+    @brief Decrement multiplier of the regenerated clock
+    @result New clock multiplier
+    */
+    constexpr ClockMultiplier decMultiplier()
+    {
+        return m_multiplier.decrement();
+    }
 
     private:
     
     // Clock divider for dividing PPQN clock down to 16th clock. This clock divider value should be set in the used HW timer directly
     static constexpr uint8_t s_baseClockDivider = 6;
     Param<Ppqn> m_ppqn = Ppqn::MIN;
+    Param<ClockMultiplier> m_multiplier = ClockMultiplier::MIN;
+    
+    // Filter coefficients of the jitter filter as power of two: Phase 1/4, period 1/32 (near critical damping)
+    static constexpr uint8_t s_phaseFilterShift = 2;
+    static constexpr uint8_t s_periodFilterShift = 5;
+    
+    enum class LockState : uint8_t
+    {
+        UNLOCKED, // No clock received
+        PHASE_LOCKED, // One clock received, period is unknown
+        LOCKED // Phase and period are tracked
+    }
+    m_lockState = LockState::UNLOCKED;
+    
+    // Estimated reception time of the last clock
+    uint16_t m_phase = 0;
+    
+    // Estimated clock period in timestamp ticks with 8 fractional bits
+    uint32_t m_period = 0;
+    
+    // Reception time of the last clock
+    uint16_t m_lastTimestamp = 0;
+    
+    // Time of the next regenerated clock event
+    uint16_t m_nextTick = 0;
+    
+    // Number of regenerated clock events not yet triggered
+    uint8_t m_nofPendingTicks = 0;
+    
+    // Timestamp rate scaled for the bpm calculation: 60 * rate * 256 / 24
+    static constexpr uint32_t s_scaledRate = (60UL * 256 / 24) * t_timestampRate;
+    
+    // Measured bpm and number of clocks since the last bpm update
+    uint16_t m_bpm = 0;
+    uint8_t m_bpmCounter = 0;
+    
+    constexpr uint16_t getPeriod() const
+    {
+        return static_cast<uint16_t>(m_period >> 8);
+    }
+    
+    constexpr uint8_t getMultiplierShift() const
+    {
+        return static_cast<uint8_t>(m_multiplier.getValue());
+    }
+    
+    // (Re-)initialize phase and period from the last two clocks
+    constexpr void lock(const uint16_t timestamp)
+    {
+        m_period = static_cast<uint32_t>(static_cast<uint16_t>(timestamp - m_lastTimestamp)) << 8;
+        m_phase = timestamp;
+        m_lockState = LockState::LOCKED;
+        scheduleTicks(timestamp);
+    }
+    
+    // Schedule the regenerated clock events for one received clock
+    constexpr void scheduleTicks(const uint16_t time)
+    {
+        // Pending clock events are triggered as soon as possible in order not to lose clock events
+        if (0 == m_nofPendingTicks)
+        {
+            m_nextTick = time;
+        }
+        
+        // Before the period is known, the multiplied clock events are triggered at once
+        m_nofPendingTicks += 1 << getMultiplierShift();
+    }
+    
+    // Update measured bpm once per quarter note
+    constexpr void updateBpm()
+    {
+        m_bpmCounter++;
+        if (m_bpmCounter < (24 << static_cast<uint8_t>(m_ppqn.getValue())))
+        {
+            return;
+        }
+        
+        m_bpmCounter = 0;
+        if (LockState::LOCKED == m_lockState)
+        {
+            // bpm = 60 * rate / (ppqn * period)
+            m_bpm = static_cast<uint16_t>(((s_scaledRate >> static_cast<uint8_t>(m_ppqn.getValue())) + (m_period >> 1)) / m_period);
+        }
+    }
 };
 
 
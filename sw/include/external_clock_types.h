@@ -67,4 +67,51 @@ struct numeric_limits <Ppqn>
     }
 };
 
+/// @brief Multiplier of the regenerated external clock, e.g. _4 generates 96 ppqn from 24 ppqn
+enum class ClockMultiplier : uint8_t
+{
+    _1 = 0,
+    _2 = 1,
+    _4 = 2,
+    _8 = 3,
+    NOFENTRIES,
+    MIN = 0,
+    MAX = NOFENTRIES - 1
+};
+
+constexpr ClockMultiplier& operator++(ClockMultiplier & arg)
+{
+    return arg = static_cast<ClockMultiplier>(static_cast<uint8_t>(arg)+1);
+}
+
+constexpr ClockMultiplier& operator--(ClockMultiplier & arg)
+{
+    return arg = static_cast<ClockMultiplier>(static_cast<uint8_t>(arg)-1);
+}
+
+/**
+@brief Numeric limits of ClockMultiplier
+*/
+template <>
+struct numeric_limits <ClockMultiplier>
+{
+    /**
+    @brief Maximum value
+    @result Maximum value of ClockMultiplier
+    */
+    static constexpr ClockMultiplier max()
+    {
+        return ClockMultiplier::MAX;
+    }
+    
+    /**
+    @brief Minimum value
+    @result Minimum value of ClockMultiplier
+    */
+    static constexpr ClockMultiplier min()
+    {
+        return ClockMultiplier::MIN;
+    }
+};
+
 #endif
\ No newline at end of file
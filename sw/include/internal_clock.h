@@ -19,6 +19,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #define INTERNAL_CLOCK_H
 
 #include "subject.h"
+#include "progmem_table.h"
 #include <stdint.h>
 
 // Internal clock needs correct CPU clock for proper timing
@@ -35,6 +36,32 @@ This implementation divides the CPU clock by a 16bit and an 8bit clock divider,
 */
 class InternalClock : public Subject<void>
 {
+    static constexpr uint16_t s_minBpm = 45;
+    
+    // Generators for the clock divider lookup tables, evaluated at compile time only
+    
+    // Get the 32bit clock divider for a bpm parameter value
+    static constexpr uint32_t computeClockDivider(const uint16_t bpmParam)
+    {
+        // Minimum bpm without clock prescaling @ 20 MHz CPU clock, 24 ppqn clock resolution, 16 bit timer resolution
+        // 20e6 * (60 / 24) / 65536 = 763 bpm
+        constexpr uint8_t ppqn = 24;
+        constexpr uint32_t scaledCpuClock = static_cast<uint32_t>((F_CPU * 60) / ppqn);
+        
+        return scaledCpuClock / (bpmParam + s_minBpm);
+    }
+    
+    // Split 32bit clock divider into a 16bit clock pre divider and an 8bit clock post divider
+    static constexpr uint8_t computeClockPostDivider(const uint16_t bpmParam)
+    {
+        return (computeClockDivider(bpmParam) >> 16) + 1;
+    }
+    
+    static constexpr uint16_t computeClockPreDivider(const uint16_t bpmParam)
+    {
+        return static_cast<uint16_t>(computeClockDivider(bpmParam) / computeClockPostDivider(bpmParam));
+    }
+    
     public:
     
     /**
@@ -52,32 +79,112 @@ class InternalClock : public Subject<void>
            
     /**
     @brief Set bpm value
+    The clock dividers for all bpm values are precomputed at compile time, so this takes constant time
+    @param bpmParam BPM parameter, 0..255 corresponds to 45..300 bpm
     */
-    constexpr void setBpmParam(const uint8_t bpmParam)
+    void setBpmParam(const uint8_t bpmParam)
     {
-        // Minimum bpm without clock prescaling @ 20 MHz CPU clock, 24 ppqn clock resolution, 16 bit timer resolution
-        // 20e6 * (60 / 24) / 65536 = 763 bpm
-        constexpr uint8_t ppqn = 24;
-        constexpr uint32_t scaledCpuClock = static_cast<uint32_t>((F_CPU * 60) / ppqn);
-
-        // Initial value for bpm counter
-        const uint16_t bpm = bpmParam + s_minBpm;
-        uint32_t clockDivider = scaledCpuClock / bpm;
+        static constexpr const PROGMEM ProgmemTable<uint16_t, 256> clockPreDivider(computeClockPreDivider);
+        static constexpr const PROGMEM ProgmemTable<uint8_t, 256> clockPostDivider(computeClockPostDivider);
         
-        // Split 32bit clock divider into a 16bit clock pre divider and an 8bit clock post divider
-        m_clockPostDivider = (clockDivider >> 16) + 1;
-        m_clockPreDivider = static_cast<uint16_t>(clockDivider / m_clockPostDivider);
+        m_clockPreDivider = clockPreDivider.getP(bpmParam);
+        m_clockPostDivider = clockPostDivider.getP(bpmParam);
         
         // Reset clock
         m_clock = m_clockPostDivider;
     }
     
+    /**
+    @brief Get 16bit clock pre divider to be used as output compare value of the associated timer
+    @result Clock pre divider
+    */
+    constexpr uint16_t getClockPreDivider() const
+    {
+        return m_clockPreDivider;
+    }
+    
     private:
     
     uint16_t m_clockPreDivider = 1;
     uint8_t m_clockPostDivider = 1;
     uint8_t m_clock = 1;
+};
+
+/**
+@brief Implementation of a bpm clock using a 32bit phase accumulator, to be used with a timer interrupt at a fixed rate
+Every timer interrupt adds a phase increment to the phase accumulator and a 24 ppqn clock event is triggered on overflow.
+Hence, the bpm resolution is 1/256 bpm and the timing error does not accumulate, as the phase remainder is carried over to the next clock event.
+The relative error of the clock rate is given by the rounding of the phase increment to half an LSB, e.g. below 0.1 ppm at 45 bpm and 10 kHz timer interrupt rate.
+The error is below 1 ppm for all bpm values if the timer interrupt rate is at most about 154 kHz
+@tparam t_tickRate Rate of the timer interrupt in Hz
+*/
+template <uint32_t t_tickRate>
+class PhaseAccumulatorClock : public Subject<void>
+{
+    // Keep the phase increment below 2^31 at 300 bpm, i.e. at most one clock event per timer interrupt
+    static_assert(t_tickRate > 2 * (300 * 24) / 60, "Timer interrupt rate is too low for 24 ppqn at 300 bpm");
+    
+    // Keep the rounding error of half an LSB below 1 ppm of the phase increment at 45 bpm
+    static_assert((45ULL * 24 * (1ULL << 32)) / (60ULL * t_tickRate) >= 500000, "Timer interrupt rate is too high for a clock rate error below 1 ppm");
+    
+    public:
+    
+    /**
+    @brief Callback for timer interrupt
+    */
+    constexpr void clock()
+    {
+        const uint32_t phase = m_phase + m_phaseIncrement;
+        
+        // Phase accumulator overflow
+        if (phase < m_phase)
+        {
+            notifyObserver();
+        }
+        
+        m_phase = phase;
+    }
+    
+    /**
+    @brief Set bpm value with fractional resolution
+    This uses a 64bit multiplication and should not be called from an interrupt
+    @param bpm BPM value in 1/256 bpm, i.e. unsigned fixed point value with 8 fractional bits
+    */
+    constexpr void setBpm(const uint32_t bpm)
+    {
+        m_phaseIncrement = static_cast<uint32_t>((bpm * s_phaseIncrementPerBpm + (1ULL << (s_fractionalBits - 1))) >> s_fractionalBits);
+    }
+    
+    /**
+    @brief Set bpm value
+    @param bpmParam BPM parameter, 0..255 corresponds to 45..300 bpm
+    */
+    constexpr void setBpmParam(const uint8_t bpmParam)
+    {
+        setBpm(static_cast<uint32_t>(bpmParam + s_minBpm) << 8);
+    }
+    
+    /**
+    @brief Reset the phase, i.e. the next clock event is triggered after one full clock period
+    */
+    constexpr void reset()
+    {
+        m_phase = 0;
+    }
+    
+    private:
+    
     static constexpr uint16_t s_minBpm = 45;
+    
+    // Fractional bits of the phase increment per 1/256 bpm, such that its rounding error is negligible even at 300 bpm.
+    // The product with the bpm value stays below 2^64 for the lowest allowed timer interrupt rate
+    static constexpr uint8_t s_fractionalBits = 24;
+    
+    // Phase increment per 1/256 bpm with s_fractionalBits fractional bits: 2^32 * 2^s_fractionalBits * 24 / (60 * 256 * t_tickRate), rounded
+    static constexpr uint64_t s_phaseIncrementPerBpm = (((1ULL << (32 + s_fractionalBits)) * 24) + ((60ULL * 256 * t_tickRate) / 2)) / (60ULL * 256 * t_tickRate);
+    
+    uint32_t m_phase = 0;
+    uint32_t m_phaseIncrement = 0;
 };
 
 #endif
\ No newline at end of file
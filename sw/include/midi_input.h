@@ -22,9 +22,12 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <stdbool.h>
 #include <optional.h>
 #include "midi_types.h"
+#include "progmem_table.h"
 
 /**
 @brief MIDI input interface parsing a serial stream of bytes into MIDI messages
+The parser is driven by two transition tables stored in progmem, one indexed by the class of a received status byte and one indexed by the current parser state for received data bytes.
+Hence, every received byte costs one table lookup and a fixed number of stores, plus the sink call if the byte completes a MIDI message.
 */
 class MidiInput
 {
@@ -36,193 +39,431 @@ class MidiInput
     constexpr MidiInput() = default;
     
     /**
-    @brief Parse a received byte of MIDI data and trigger notifications on complete MIDI messages
+    @brief Parse a received byte of MIDI data
     @param rxByte One byte of received MIDI data
+    @result MIDI message completed by the received byte, if any
+    @note SysEx data is only passed to sinks, see parse(const uint8_t, Sink&)
     @todo sicher stellen, dass eine message ohne datenbyte nur einmal empfangen wird
-    @todo SysEx status geht vermutlich verloren!!!
     */
     Optional<MidiMessage> parse(const uint8_t rxByte)
+    {
+        OptionalSink sink;
+        parse(rxByte, sink);
+        return sink.m_message;
+    }
+    
+    /**
+    @brief Parse a received byte of MIDI data and pass a completed MIDI message to a sink
+    @tparam Sink Class implementing operator() for every MIDI message type, e.g. operator()(const MidiNoteOn&), and for MidiSysExChunk
+    @param rxByte One byte of received MIDI data
+    @param sink Sink receiving completed MIDI messages
+    */
+    template <typename Sink>
+    void parse(const uint8_t rxByte, Sink& sink)
     {
         // Check if received byte is a status byte
         const MidiStatus status(rxByte);
         if (status.statusFlag)
         {
-            return parsestatus(status);
+            parseStatus(status, sink);
         }
         else
         {
-            return parseDataByte(rxByte);
+            parseDataByte(rxByte, sink);
+        }
+    }
+    
+    /**
+    @brief Parse a buffer of received MIDI data and pass all completed MIDI messages to a sink
+    This avoids constructing a MidiMessage for every received byte, e.g. when draining a UART receive buffer in the main loop
+    @tparam Sink Class implementing operator() for every MIDI message type, e.g. operator()(const MidiNoteOn&), and for MidiSysExChunk
+    @param begin Pointer to the first byte of received MIDI data
+    @param end Pointer past the last byte of received MIDI data
+    @param sink Sink receiving completed MIDI messages
+    */
+    template <typename Sink>
+    void parse(const uint8_t * begin, const uint8_t * const end, Sink& sink)
+    {
+        while (begin != end)
+        {
+            parse(*begin++, sink);
         }
     }
     
+    /**
+    @brief Receive only SysEx messages with the given 1-byte manufacturer ID
+    @param id Manufacturer ID
+    */
+    constexpr void setSysExManufacturerId(const uint8_t id)
+    {
+        m_sysExId[0] = id;
+        m_sysExIdLength = 1;
+    }
+    
+    /**
+    @brief Receive only SysEx messages with the given extended 3-byte manufacturer ID 0x00 id1 id2
+    @param id1 Second byte of manufacturer ID
+    @param id2 Third byte of manufacturer ID
+    */
+    constexpr void setSysExManufacturerId(const uint8_t id1, const uint8_t id2)
+    {
+        m_sysExId[0] = 0x00;
+        m_sysExId[1] = id1;
+        m_sysExId[2] = id2;
+        m_sysExIdLength = 3;
+    }
+    
+    /**
+    @brief Receive SysEx messages regardless of their manufacturer ID
+    */
+    constexpr void clearSysExManufacturerId()
+    {
+        m_sysExIdLength = 0;
+    }
+    
+    /**
+    @brief Set the MIDI channel filter
+    Channel messages on disabled channels are discarded at the status byte, so their data bytes are skipped without constructing a MIDI message
+    @param channelMask Bit mask with bit n enabling MIDI channel n+1
+    */
+    constexpr void setChannelFilter(const uint16_t channelMask)
+    {
+        m_channelFilter[0] = static_cast<uint8_t>(channelMask);
+        m_channelFilter[1] = static_cast<uint8_t>(channelMask >> 8);
+    }
+    
+    /**
+    @brief Set the MIDI command filter
+    Messages with disabled commands are discarded at the status byte, so their data bytes are skipped without constructing a MIDI message
+    @param commandMask Bit mask with bit n enabling MidiCommand n. The bit of MidiCommand::SYSEX_MESSAGE enables SysEx messages, real-time messages are never filtered
+    */
+    constexpr void setCommandFilter(const uint8_t commandMask)
+    {
+        m_commandFilter = commandMask;
+    }
+    
     private:
-
-    // Parse a status byte
-    Optional<MidiMessage> parsestatus(const MidiStatus status)
+    
+    // Sink storing a completed MIDI message for the byte-wise parse() interface
+    struct OptionalSink
     {
-        m_currentMidiData.status = status;
+        template <typename Message>
+        void operator()(const Message& message)
+        {
+            m_message = Optional<MidiMessage>(MidiMessage{in_place_type_t<Message>(), message});
+        }
+        
+        // SysEx data is not supported by the byte-wise interface
+        void operator()(const MidiSysExChunk&)
+        {}
         
-        // Change parser state according to received MIDI command
-        switch (status.command)
+        Optional<MidiMessage> m_message;
+    };
+
+    // State of MIDI parser
+    enum State : uint8_t
+    {
+        IDLE = 0, // Parser is in idle state, all data bytes are discarded
+        NOTE_OFF_STATUS_RECEIVED, // Parser has received the status byte of a note-off message
+        NOTE_OFF_DATA_RECEIVED, // Parser has received the first data byte of a note-off message
+        NOTE_ON_STATUS_RECEIVED, // Parser has received the status byte of a note-on message
+        NOTE_ON_DATA_RECEIVED, // Parser has received the first data byte of a note-on message
+        POLY_AFTER_TOUCH_STATUS_RECEIVED, // Parser has received the status byte of a polyphonic aftertouch message
+        POLY_AFTER_TOUCH_DATA_RECEIVED, // Parser has received the first data byte of a polyphonic aftertouch message
+        CONTROL_CHANGE_STATUS_RECEIVED, // Parser has received the status byte of a control change message
+        CONTROL_CHANGE_DATA_RECEIVED, // Parser has received the first data byte of a control change message
+        PROGRAM_CHANGE_STATUS_RECEIVED, // Parser has received the status byte of a program change message
+        CHANNEL_AFTER_TOUCH_STATUS_RECEIVED, // Parser has received the status byte of a channel aftertouch message
+        PITCH_BEND_CHANGE_STATUS_RECEIVED, // Parser has received the status byte of a pitch-bend message
+        PITCH_BEND_CHANGE_DATA_RECEIVED, // Parser has received the first data byte of a pitch-bend message
+        SYSEX_MESSAGE_RECEIVED, // Parser has received a system common message or a discarded SysEx message
+        SYSEX_DATA_RECEIVED, // Parser is receiving the data bytes of a SysEx message
+        NOFSTATES
+    }
+    m_state {IDLE};
+    
+    // A transition is packed into one byte: The upper nibble holds the next parser state, the lower nibble holds action flags
+    static_assert(NOFSTATES <= 16, "Parser state does not fit into the upper nibble of a transition");
+    
+    static constexpr uint8_t makeTransition(const State nextState, const uint8_t actions)
+    {
+        return (nextState << 4) | actions;
+    }
+    
+    static constexpr State getNextState(const uint8_t transition)
+    {
+        return static_cast<State>(transition >> 4);
+    }
+    
+    // Actions on reception of a status byte
+    static constexpr uint8_t STATUS_SET_STATE = 0x01; // Store status byte and change parser state
+    static constexpr uint8_t STATUS_REALTIME = 0x02; // Emit a real-time message, parser state is not affected
+    static constexpr uint8_t STATUS_SYSEX_BEGIN = 0x04; // Start receiving a SysEx message
+    
+    // Actions on reception of a data byte
+    static constexpr uint8_t DATA_STORE = 0x01; // Store the data byte
+    static constexpr uint8_t DATA_SECOND = 0x02; // Store the data byte as second data byte
+    static constexpr uint8_t DATA_COMPLETE = 0x04; // Data byte completes a MIDI message
+    static constexpr uint8_t DATA_SYSEX = 0x08; // Data byte is part of a SysEx message
+    
+    // Status bytes are classified into channel messages (one class per MIDI command) and system messages (one class per status byte)
+    static constexpr uint8_t s_nofStatusClasses = static_cast<uint8_t>(MidiCommand::SYSEX_MESSAGE) + 16;
+    
+    static constexpr uint8_t getStatusClass(const uint8_t statusByte)
+    {
+        return (statusByte < 0xF0) ? ((statusByte >> 4) & 0x07) : (statusByte - 0xF0 + static_cast<uint8_t>(MidiCommand::SYSEX_MESSAGE));
+    }
+    
+    // Generator for the status byte transition table
+    static constexpr uint8_t getStatusTransition(const uint16_t statusClass)
+    {
+        switch (statusClass)
         {
-            case MidiCommand::NOTE_OFF:
-            m_state = NOTE_OFF_STATUS_RECEIVED;
-            break;
+            case static_cast<uint8_t>(MidiCommand::NOTE_OFF):
+            return makeTransition(NOTE_OFF_STATUS_RECEIVED, STATUS_SET_STATE);
             
-            case MidiCommand::NOTE_ON:
-            m_state = NOTE_ON_STATUS_RECEIVED;
-            break;
+            case static_cast<uint8_t>(MidiCommand::NOTE_ON):
+            return makeTransition(NOTE_ON_STATUS_RECEIVED, STATUS_SET_STATE);
             
-            case MidiCommand::POLY_AFTER_TOUCH:
-            m_state = POLY_AFTER_TOUCH_STATUS_RECEIVED;
-            break;
+            case static_cast<uint8_t>(MidiCommand::POLY_AFTER_TOUCH):
+            return makeTransition(POLY_AFTER_TOUCH_STATUS_RECEIVED, STATUS_SET_STATE);
             
-            case MidiCommand::CONTROL_CHANGE:
-            m_state = CONTROL_CHANGE_STATUS_RECEIVED;
-            break;
+            case static_cast<uint8_t>(MidiCommand::CONTROL_CHANGE):
+            return makeTransition(CONTROL_CHANGE_STATUS_RECEIVED, STATUS_SET_STATE);
             
-            case MidiCommand::PROGRAM_CHANGE:
-            m_state = PROGRAM_CHANGE_STATUS_RECEIVED;
-            break;
+            case static_cast<uint8_t>(MidiCommand::PROGRAM_CHANGE):
+            return makeTransition(PROGRAM_CHANGE_STATUS_RECEIVED, STATUS_SET_STATE);
             
-            case MidiCommand::CHANNEL_AFTER_TOUCH:
-            m_state = CHANNEL_AFTER_TOUCH_STATUS_RECEIVED;
-            break;
+            case static_cast<uint8_t>(MidiCommand::CHANNEL_AFTER_TOUCH):
+            return makeTransition(CHANNEL_AFTER_TOUCH_STATUS_RECEIVED, STATUS_SET_STATE);
             
-            case MidiCommand::PITCH_BEND_CHANGE:
-            m_state = PITCH_BEND_CHANGE_STATUS_RECEIVED;
-            break;
+            case static_cast<uint8_t>(MidiCommand::PITCH_BEND_CHANGE):
+            return makeTransition(PITCH_BEND_CHANGE_STATUS_RECEIVED, STATUS_SET_STATE);
+            
+            // SysEx real-time messages may be transmitted anytime and must not affect the parser state
+            case getStatusClass(static_cast<uint8_t>(MidiSysExMessage::TIMING_CLOCK)):
+            case getStatusClass(static_cast<uint8_t>(MidiSysExMessage::START)):
+            case getStatusClass(static_cast<uint8_t>(MidiSysExMessage::CONTINUE)):
+            case getStatusClass(static_cast<uint8_t>(MidiSysExMessage::STOP)):
+            case getStatusClass(static_cast<uint8_t>(MidiSysExMessage::ACTIVE_SENSE)):
+            case getStatusClass(static_cast<uint8_t>(MidiSysExMessage::RESET)):
+            return makeTransition(IDLE, STATUS_REALTIME);
+            
+            // Undefined real-time messages are ignored
+            case getStatusClass(0xF9):
+            case getStatusClass(0xFD):
+            return makeTransition(IDLE, 0);
+            
+            case getStatusClass(static_cast<uint8_t>(MidiSysExMessage::BEGIN)):
+            return makeTransition(SYSEX_DATA_RECEIVED, STATUS_SET_STATE | STATUS_SYSEX_BEGIN);
+            
+            // SysEx end and system common messages
+            default:
+            return makeTransition(SYSEX_MESSAGE_RECEIVED, STATUS_SET_STATE);
+        }
+    }
+    
+    // Generator for the data byte transition table
+    static constexpr uint8_t getDataTransition(const uint16_t state)
+    {
+        switch (state)
+        {
+            case NOTE_OFF_STATUS_RECEIVED:
+            return makeTransition(NOTE_OFF_DATA_RECEIVED, DATA_STORE);
+            
+            case NOTE_OFF_DATA_RECEIVED:
+            return makeTransition(NOTE_OFF_STATUS_RECEIVED, DATA_STORE | DATA_SECOND | DATA_COMPLETE); // Running status
+            
+            case NOTE_ON_STATUS_RECEIVED:
+            return makeTransition(NOTE_ON_DATA_RECEIVED, DATA_STORE);
+            
+            case NOTE_ON_DATA_RECEIVED:
+            return makeTransition(NOTE_ON_STATUS_RECEIVED, DATA_STORE | DATA_SECOND | DATA_COMPLETE); // Running status
+            
+            case POLY_AFTER_TOUCH_STATUS_RECEIVED:
+            return makeTransition(POLY_AFTER_TOUCH_DATA_RECEIVED, DATA_STORE);
+            
+            case POLY_AFTER_TOUCH_DATA_RECEIVED:
+            return makeTransition(POLY_AFTER_TOUCH_STATUS_RECEIVED, DATA_STORE | DATA_SECOND | DATA_COMPLETE); // Running status
+            
+            case CONTROL_CHANGE_STATUS_RECEIVED:
+            return makeTransition(CONTROL_CHANGE_DATA_RECEIVED, DATA_STORE);
+            
+            case CONTROL_CHANGE_DATA_RECEIVED:
+            return makeTransition(CONTROL_CHANGE_STATUS_RECEIVED, DATA_STORE | DATA_SECOND | DATA_COMPLETE); // Running status
+            
+            case PROGRAM_CHANGE_STATUS_RECEIVED:
+            return makeTransition(PROGRAM_CHANGE_STATUS_RECEIVED, DATA_STORE | DATA_COMPLETE); // Running status
+            
+            case CHANNEL_AFTER_TOUCH_STATUS_RECEIVED:
+            return makeTransition(CHANNEL_AFTER_TOUCH_STATUS_RECEIVED, DATA_STORE | DATA_COMPLETE); // Running status
+            
+            case PITCH_BEND_CHANGE_STATUS_RECEIVED:
+            return makeTransition(PITCH_BEND_CHANGE_DATA_RECEIVED, DATA_STORE);
             
-            case MidiCommand::SYSEX_MESSAGE:
+            case PITCH_BEND_CHANGE_DATA_RECEIVED:
+            return makeTransition(PITCH_BEND_CHANGE_STATUS_RECEIVED, DATA_STORE | DATA_SECOND | DATA_COMPLETE); // Running status
+            
+            case SYSEX_DATA_RECEIVED:
+            return makeTransition(SYSEX_DATA_RECEIVED, DATA_SYSEX);
+            
+            default:
+            return makeTransition(static_cast<State>(state), 0);
+        }
+    }
+
+    // Parse a status byte
+    template <typename Sink>
+    void parseStatus(const MidiStatus status, Sink& sink)
+    {
+        static constexpr const PROGMEM ProgmemTable<uint8_t, s_nofStatusClasses> transitions(getStatusTransition);
+        
+        const uint8_t transition = transitions.getP(getStatusClass(status.byte));
+        if (transition & STATUS_SET_STATE)
+        {
+            // Any status byte other than a real-time message terminates a SysEx message
+            if (SYSEX_DATA_RECEIVED == m_state)
             {
-                // Filter SysEx real-time messages
-                // These types of messages may be transmitted anytime and must not affect the parser output
-                switch (status.sysExMessage)
-                {
-                    case MidiSysExMessage::TIMING_CLOCK: // Midi Clock
-                    case MidiSysExMessage::START: // Start Command
-                    case MidiSysExMessage::CONTINUE: // Continue Command
-                    case MidiSysExMessage::STOP: // Stop Command
-                    case MidiSysExMessage::ACTIVE_SENSE: // Active Sensing
-                    case MidiSysExMessage::RESET: // System Reset
-                    m_state = SYSEX_MESSAGE_RECEIVED;
-                    return MidiMessage{in_place_type_t<MidiSysExMessage>(),status.sysExMessage};
-                    
-                    default:
-                    m_state = SYSEX_MESSAGE_RECEIVED;
-                    break;
-                }
+                endSysEx(sink);
             }
-            break;
             
-            default:
-            m_state = IDLE;
-            break;
+            if (transition & STATUS_SYSEX_BEGIN)
+            {
+                m_sysExLength = 0;
+                m_sysExIdIndex = 0;
+            }
+            
+            m_currentMidiData.status = status;
+            m_state = getNextState(transition);
+            
+            // Discard all data bytes of filtered messages
+            if (!isAccepted(status))
+            {
+                m_state = (SYSEX_DATA_RECEIVED == m_state) ? SYSEX_MESSAGE_RECEIVED : IDLE;
+            }
+        }
+        else if (transition & STATUS_REALTIME)
+        {
+            sink(status.sysExMessage);
         }
+    }
+    
+    // Check a status byte against the channel and command filters
+    bool isAccepted(const MidiStatus status) const
+    {
+        static constexpr const PROGMEM ProgmemTable<uint8_t, 8> bitMasks([](const uint16_t bit) {return static_cast<uint8_t>(1 << bit);});
         
-        return Optional<MidiMessage>();
+        if (!(m_commandFilter & bitMasks.getP(static_cast<uint8_t>(status.command))))
+        {
+            return false;
+        }
+        
+        if (MidiCommand::SYSEX_MESSAGE == status.command)
+        {
+            return true;
+        }
+        
+        const uint8_t channel = static_cast<uint8_t>(status.channel);
+        return m_channelFilter[channel >> 3] & bitMasks.getP(channel & 0x07);
     }
     
     // Parse a data byte
-    Optional<MidiMessage> parseDataByte(const uint8_t byte)
+    template <typename Sink>
+    void parseDataByte(const uint8_t byte, Sink& sink)
     {
-        // Received byte is a data byte
-        switch (m_state)
+        static constexpr const PROGMEM ProgmemTable<uint8_t, NOFSTATES> transitions(getDataTransition);
+        
+        const uint8_t transition = transitions.getP(m_state);
+        m_state = getNextState(transition);
+        if (transition & DATA_STORE)
         {
-            case NOTE_OFF_STATUS_RECEIVED: // Parser has received the status byte of a note-off message
-            m_currentMidiData.data[0] = byte;
-            m_state = NOTE_OFF_DATA_RECEIVED;
-            break;
-
-            case NOTE_OFF_DATA_RECEIVED: // Parser has received the first data byte of a note-off message
-            m_currentMidiData.data[1] = byte;
-            m_state = NOTE_OFF_STATUS_RECEIVED; // Running status
-            return MidiMessage{in_place_type_t<MidiNoteOff>(), m_currentMidiData.noteOff};
-
-            case NOTE_ON_STATUS_RECEIVED: // Parser has received the status byte of a note-on message
-            m_currentMidiData.data[0] = byte;
-            m_state = NOTE_ON_DATA_RECEIVED;
-            break;
-
-            case NOTE_ON_DATA_RECEIVED: // Parser has received the first data byte of a note-on message
-            m_currentMidiData.data[1] = byte;
-            m_state = NOTE_ON_STATUS_RECEIVED; // Running status
-            return MidiMessage{in_place_type_t<MidiNoteOn>(), m_currentMidiData.noteOn};
-
-            case POLY_AFTER_TOUCH_STATUS_RECEIVED: // Parser has received the status byte of a polyphonic aftertouch message
-            m_currentMidiData.data[0] = byte;
-            m_state = POLY_AFTER_TOUCH_DATA_RECEIVED;
-            break;
-
-            case POLY_AFTER_TOUCH_DATA_RECEIVED: // Parser has received the first data byte of a polyphonic aftertouch message
-            m_currentMidiData.data[1] = byte;
-            m_state = POLY_AFTER_TOUCH_STATUS_RECEIVED; // Running status
-            return MidiMessage{in_place_type_t<MidiPolyAfterTouch>(), m_currentMidiData.polyAftertouch};
-            break;
-
-            case CONTROL_CHANGE_STATUS_RECEIVED: // Parser has received the status byte of a control change message
-            m_currentMidiData.data[0] = byte;
-            m_state = CONTROL_CHANGE_DATA_RECEIVED;
+            m_currentMidiData.data[(transition & DATA_SECOND) ? 1 : 0] = byte;
+        }
+        
+        if (transition & DATA_COMPLETE)
+        {
+            emitMessage(sink);
+        }
+        
+        if (transition & DATA_SYSEX)
+        {
+            parseSysExByte(byte, sink);
+        }
+    }
+    
+    // Parse a data byte of a SysEx message
+    template <typename Sink>
+    void parseSysExByte(const uint8_t byte, Sink& sink)
+    {
+        // Discard the whole message if the manufacturer ID does not match
+        if (m_sysExIdIndex < m_sysExIdLength)
+        {
+            if (byte != m_sysExId[m_sysExIdIndex++])
+            {
+                m_state = SYSEX_MESSAGE_RECEIVED;
+                return;
+            }
+        }
+        
+        // Pass the buffer to the sink as soon as it is full
+        m_sysExBuffer[m_sysExLength++] = byte;
+        if (s_sysExBufferSize == m_sysExLength)
+        {
+            sink(MidiSysExChunk{m_sysExBuffer, m_sysExLength, false});
+            m_sysExLength = 0;
+        }
+    }
+    
+    // Pass the remaining data of a SysEx message to the sink
+    template <typename Sink>
+    void endSysEx(Sink& sink)
+    {
+        // Messages which are too short to contain the complete manufacturer ID are discarded
+        if (m_sysExIdIndex == m_sysExIdLength)
+        {
+            sink(MidiSysExChunk{m_sysExBuffer, m_sysExLength, true});
+        }
+    }
+    
+    // Pass the completed MIDI message to the sink
+    template <typename Sink>
+    void emitMessage(Sink& sink) const
+    {
+        switch (m_currentMidiData.status.command)
+        {
+            case MidiCommand::NOTE_OFF:
+            sink(m_currentMidiData.noteOff);
             break;
-
-            case CONTROL_CHANGE_DATA_RECEIVED: // Parser has received the first data byte of a control change message
-            m_currentMidiData.data[1] = byte;
-            m_state = CONTROL_CHANGE_STATUS_RECEIVED; // Running status
-            return MidiMessage{in_place_type_t<MidiControlChange>(), m_currentMidiData.controlChange};
+            
+            case MidiCommand::NOTE_ON:
+            sink(m_currentMidiData.noteOn);
             break;
-
-            case PROGRAM_CHANGE_STATUS_RECEIVED: // Parser has received the status byte of a program change message
-            m_currentMidiData.data[0] = byte;
-            return MidiMessage{in_place_type_t<MidiProgramChange>(), m_currentMidiData.programChange};
+            
+            case MidiCommand::POLY_AFTER_TOUCH:
+            sink(m_currentMidiData.polyAftertouch);
             break;
-
-            case CHANNEL_AFTER_TOUCH_STATUS_RECEIVED: // Parser has received the status byte of a channel aftertouch message
-            m_currentMidiData.data[0] = byte;
-            return MidiMessage{in_place_type_t<MidiChannelAfterTouch>(), m_currentMidiData.channelAftertouch};
+            
+            case MidiCommand::CONTROL_CHANGE:
+            sink(m_currentMidiData.controlChange);
             break;
-
-            case PITCH_BEND_CHANGE_STATUS_RECEIVED: // Parser has received the status byte of a pitch-bend message
-            m_currentMidiData.data[0] = byte;
-            m_state = PITCH_BEND_CHANGE_DATA_RECEIVED;
+            
+            case MidiCommand::PROGRAM_CHANGE:
+            sink(m_currentMidiData.programChange);
             break;
-
-            case PITCH_BEND_CHANGE_DATA_RECEIVED: // Parser has received the first data byte of a pitch-bend message
-            m_currentMidiData.data[1] = byte;
-            return MidiMessage{in_place_type_t<MidiPitchBend>(), m_currentMidiData.pitchBend};
-            m_state = PITCH_BEND_CHANGE_STATUS_RECEIVED;
+            
+            case MidiCommand::CHANNEL_AFTER_TOUCH:
+            sink(m_currentMidiData.channelAftertouch);
             break;
-
-            case SYSEX_MESSAGE_RECEIVED: // Parser has received a SysEx message
-            /// @todo Support SysEx messages
+            
+            case MidiCommand::PITCH_BEND_CHANGE:
+            sink(m_currentMidiData.pitchBend);
             break;
-
+            
             default:
             break;
         }
-
-        return Optional<MidiMessage>();
     }
     
-    // State of MIDI parser
-    enum
-    {
-        IDLE = 0, // Parser is in idle state after a real-time SysEx Message has been received
-        NOTE_OFF_STATUS_RECEIVED, // Parser has received the status byte of a note-off message
-        NOTE_OFF_DATA_RECEIVED, // Parser has received the first data byte of a note-off message
-        NOTE_ON_STATUS_RECEIVED, // Parser has received the status byte of a note-on message
-        NOTE_ON_DATA_RECEIVED, // Parser has received the first data byte of a note-on message
-        POLY_AFTER_TOUCH_STATUS_RECEIVED, // Parser has received the status byte of a polyphonic aftertouch message
-        POLY_AFTER_TOUCH_DATA_RECEIVED, // Parser has received the first data byte of a polyphonic aftertouch message
-        CONTROL_CHANGE_STATUS_RECEIVED, // Parser has received the status byte of a control change message
-        CONTROL_CHANGE_DATA_RECEIVED, // Parser has received the first data byte of a control change message
-        PROGRAM_CHANGE_STATUS_RECEIVED, // Parser has received the status byte of a program change message
-        CHANNEL_AFTER_TOUCH_STATUS_RECEIVED, // Parser has received the status byte of a channel aftertouch message
-        PITCH_BEND_CHANGE_STATUS_RECEIVED, // Parser has received the status byte of a pitch-bend message
-        PITCH_BEND_CHANGE_DATA_RECEIVED, // Parser has received the first data byte of a pitch-bend message
-        SYSEX_MESSAGE_RECEIVED // Parser has received a SysEx message
-    }
-    m_state {IDLE};
-
     // MIDI data collected during parsing the serial stream
     union
     {
@@ -245,6 +486,20 @@ class MidiInput
         MidiSysEx sysEx;
     }
     m_currentMidiData;
+    
+    // Buffer for SysEx data, which is passed to the sink in chunks
+    static constexpr uint8_t s_sysExBufferSize = 16;
+    uint8_t m_sysExBuffer[s_sysExBufferSize] {};
+    uint8_t m_sysExLength {0};
+    
+    // Manufacturer ID filter for SysEx messages
+    uint8_t m_sysExId[3] {};
+    uint8_t m_sysExIdLength {0};
+    uint8_t m_sysExIdIndex {0};
+    
+    // Message filters, all messages are accepted by default
+    uint8_t m_channelFilter[2] {0xFF, 0xFF};
+    uint8_t m_commandFilter {0xFF};
 };
 
 #endif
\ No newline at end of file
@@ -24,8 +24,10 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 /**
 @brief MIDI output interface translating synthesizer events into MIDI messages
 @tparam Output Output driver class implementing a static method put(uint8_t), e.g. USART
+@tparam t_runningStatus Flag enabling running status, i.e. status bytes equal to the previously sent status byte are omitted and note off messages are sent as note on messages with velocity 0
+@tparam t_statusRefreshInterval Number of messages after which an unchanged status byte is sent again when using running status, 0 disables the refresh
 */
-template <typename Output>
+template <typename Output, bool t_runningStatus = false, uint8_t t_statusRefreshInterval = 0>
 class MidiOutput
 {
     public:
@@ -37,7 +39,7 @@ class MidiOutput
     */
     static void write(const MidiNoteOn & message)
     {
-        Output::put(message.status.byte);
+        putStatus(message.status.byte);
         Output::put(message.note);
         Output::put(message.velocity);
     }
@@ -49,7 +51,16 @@ class MidiOutput
     */
     static void write(const MidiNoteOff & message)
     {
-        Output::put(message.status.byte);
+        if constexpr (t_runningStatus)
+        {
+            // Send note on with velocity 0 in order not to break running status of note on messages. The note off velocity is lost
+            putStatus(message.status.byte | s_noteOnFlag);
+            Output::put(message.note);
+            Output::put(0);
+            return;
+        }
+        
+        putStatus(message.status.byte);
         Output::put(message.note);
         Output::put(message.velocity);
     }
@@ -62,7 +73,7 @@ class MidiOutput
     */
     static void writeControlChange(const uint8_t status, const uint8_t controller, const uint8_t value)
     {
-        Output::put(status);
+        putStatus(status);
         Output::put(controller);
         Output::put(value);
     }
@@ -95,7 +106,7 @@ class MidiOutput
     */
     static void write(const MidiProgramChange & message)
     {
-        Output::put(message.status.byte);
+        putStatus(message.status.byte);
         Output::put(message.program);
     }
     
@@ -106,7 +117,7 @@ class MidiOutput
     */
     static void write(const MidiPolyAfterTouch & message)
     {
-        Output::put(message.status.byte);
+        putStatus(message.status.byte);
         Output::put(message.note);
         Output::put(message.velocity);
     }
@@ -118,7 +129,7 @@ class MidiOutput
     */
     static void write(const MidiChannelAfterTouch & message)
     {
-        Output::put(message.status.byte);
+        putStatus(message.status.byte);
         Output::put(message.velocity);
     }
 
@@ -129,7 +140,7 @@ class MidiOutput
     */
     static void write(const MidiPitchBend & message)
     {
-        Output::put(message.status.byte);
+        putStatus(message.status.byte);
         Output::put(message.LSB);
         Output::put(message.MSB);
     }
@@ -141,8 +152,65 @@ class MidiOutput
     */
     static void write(const MidiSysEx & message)
     {
+        if constexpr (t_runningStatus)
+        {
+            // SysEx and system common status bytes cancel running status, real-time messages do not
+            if (message.data >= 0x80 && message.data < 0xF8)
+            {
+                s_runningStatus = 0;
+            }
+        }
+        
         Output::put(message.data);
     }
+    
+    private:
+    
+    // Send status byte, which is omitted if running status is enabled and the status byte has not changed
+    static void putStatus(const uint8_t status)
+    {
+        if constexpr (t_runningStatus)
+        {
+            if (status == s_runningStatus && !isOutputDropping())
+            {
+                if constexpr (0 == t_statusRefreshInterval)
+                {
+                    return;
+                }
+                else if (++s_nofRunningStatusMessages < t_statusRefreshInterval)
+                {
+                    return;
+                }
+            }
+            
+            s_runningStatus = status;
+            s_nofRunningStatusMessages = 0;
+        }
+        
+        Output::put(status);
+    }
+    
+    // Bit turning a note off status byte into a note on status byte
+    static constexpr uint8_t s_noteOnFlag = 0x10;
+    
+    // Check if the output driver drops bytes until the next status byte, which then has to be sent regardless of running status
+    static bool isOutputDropping()
+    {
+        if constexpr (requires { Output::isDropping(); })
+        {
+            return Output::isDropping();
+        }
+        else
+        {
+            return false;
+        }
+    }
+    
+    // Last status byte sent. Zero is not a valid status byte, so the first status byte is always sent
+    static inline uint8_t s_runningStatus = 0;
+    
+    // Number of messages sent without status byte since the status byte has been sent
+    static inline uint8_t s_nofRunningStatusMessages = 0;
 };
 
 #endif
\ No newline at end of file
@@ -217,6 +217,15 @@ struct MidiSysEx
     uint8_t data;
 };
 
+/// @brief Chunk of a streamed MIDI SysEx message
+/// The data pointer refers to the internal buffer of the parser and is only valid until the sink returns
+struct MidiSysExChunk
+{
+    const uint8_t * data;
+    uint8_t length;
+    bool last; // Flag indicating the final chunk of a SysEx message, which may be empty
+};
+
 using MidiMessage = Variant<
 MidiNoteOff,
 MidiNoteOn,
@@ -0,0 +1,129 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef PARAM_SLEW_H
+#define PARAM_SLEW_H
+
+#include <stdint.h>
+
+/**
+@brief Linear slew limiter for 8-bit parameters using q8.8 fixed-point arithmetic
+The smoothed value ramps toward the target value by a constant increment per tick
+*/
+class ParamSlew
+{
+    public:
+    
+    /**
+    @brief Constructor
+    @param value Initial value
+    */
+    constexpr ParamSlew(const uint8_t value = 0)
+    :
+    m_value(static_cast<uint16_t>(value) << 8),
+    m_target(value)
+    {}
+    
+    /**
+    @brief Set the slew rate
+    Disabling smoothing during a ramp sets the smoothed value to the target value immediately
+    @param increment Change of the smoothed value per tick in q8.8 format. 0 disables smoothing
+    @result true if the smoothed value has changed
+    */
+    constexpr bool setRate(const uint16_t increment)
+    {
+        m_increment = increment;
+        if (0 == increment)
+        {
+            return setValue(m_target);
+        }
+        
+        return false;
+    }
+    
+    /**
+    @brief Set the target value
+    Without smoothing, the smoothed value follows the target value immediately
+    @param target Target value
+    @result true if the smoothed value has changed
+    */
+    constexpr bool setTarget(const uint8_t target)
+    {
+        m_target = target;
+        if (0 == m_increment)
+        {
+            return setValue(target);
+        }
+        
+        return false;
+    }
+    
+    /**
+    @brief Set the smoothed value and the target value immediately
+    @param value New value
+    @result true if the smoothed value has changed
+    */
+    constexpr bool setValue(const uint8_t value)
+    {
+        const uint8_t oldValue = getValue();
+        m_target = value;
+        m_value = static_cast<uint16_t>(value) << 8;
+        return value != oldValue;
+    }
+    
+    /**
+    @brief Advance the smoothed value by one tick towards the target value
+    @result true if the integer part of the smoothed value has changed
+    */
+    constexpr bool tick()
+    {
+        const uint8_t oldValue = getValue();
+        const uint16_t target = static_cast<uint16_t>(m_target) << 8;
+        
+        if (m_value < target)
+        {
+            m_value = (target - m_value > m_increment) ? m_value + m_increment : target;
+        }
+        else if (m_value > target)
+        {
+            m_value = (m_value - target > m_increment) ? m_value - m_increment : target;
+        }
+        
+        return getValue() != oldValue;
+    }
+    
+    /**
+    @brief Get the integer part of the smoothed value
+    */
+    [[nodiscard]] constexpr uint8_t getValue() const
+    {
+        return static_cast<uint8_t>(m_value >> 8);
+    }
+    
+    private:
+    
+    // Smoothed value in q8.8 format
+    uint16_t m_value;
+    
+    // Target value
+    uint8_t m_target;
+    
+    // Change of the smoothed value per tick in q8.8 format
+    uint16_t m_increment {0};
+};
+
+#endif
@@ -0,0 +1,103 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef PROGMEM_TABLE_H
+#define PROGMEM_TABLE_H
+
+#include <avr/pgmspace.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+@brief Dense lookup table which is generated at compile time and intended to be stored in progmem
+@tparam T Type of the table entries, has to be trivially copyable
+@tparam t_size Number of table entries
+*/
+template <typename T, uint16_t t_size>
+class ProgmemTable
+{
+    public:
+    
+    /**
+    @brief Constructor generating all table entries at compile time
+    @param generator Constexpr function returning the table entry for a given index
+    */
+    template <typename Generator>
+    constexpr ProgmemTable(const Generator generator)
+    {
+        for (uint16_t index = 0; index < t_size; ++index)
+        {
+            m_data[index] = generator(index);
+        }
+    }
+    
+    /**
+    @brief Number of table entries
+    */
+    static constexpr uint16_t size()
+    {
+        return t_size;
+    }
+    
+    /**
+    @brief Read a table entry from progmem
+    @param index Index of the table entry
+    @result Table entry
+    */
+    T getP(const uint16_t index) const
+    {
+        T value;
+        if constexpr (sizeof(T) == 1)
+        {
+            const uint8_t raw = pgm_read_byte(&m_data[index]);
+            memcpy(&value, &raw, sizeof(T));
+        }
+        else if constexpr (sizeof(T) == 2)
+        {
+            const uint16_t raw = pgm_read_word(&m_data[index]);
+            memcpy(&value, &raw, sizeof(T));
+        }
+        else if constexpr (sizeof(T) == 4)
+        {
+            const uint32_t raw = pgm_read_dword(&m_data[index]);
+            memcpy(&value, &raw, sizeof(T));
+        }
+        else
+        {
+            memcpy_P(&value, &m_data[index], sizeof(T));
+        }
+        
+        return value;
+    }
+    
+    /**
+    @brief Access a table entry at compile time
+    This must only be used in constant expressions, as the table itself may be located in progmem
+    @param index Index of the table entry
+    @result Table entry
+    */
+    constexpr const T& operator[](const uint16_t index) const
+    {
+        return m_data[index];
+    }
+    
+    private:
+    
+    T m_data[t_size] {};
+};
+
+#endif
@@ -0,0 +1,114 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SWING_CLOCK_H
+#define SWING_CLOCK_H
+
+#include "subject.h"
+#include <stdint.h>
+
+/**
+@brief Swing stage dividing a ppqn clock into steps, wherein every even-numbered step is delayed
+The swing stage is placed between a clock source (e.g. InternalClock or ExternalClock) and the step observers (e.g. Arpeggiator::clock()).
+Swing is realized by counting clock ticks, i.e. odd-numbered steps last longer and even-numbered steps last shorter by the same number of ticks.
+Hence, the swing resolution is given by the ppqn resolution of the clock source
+*/
+class SwingClock : public Subject<void>
+{
+    public:
+    
+    /**
+    @brief Callback for clock event of the clock source
+    */
+    constexpr void clock()
+    {
+        if (0 == --m_countdown)
+        {
+            notifyObserver();
+            m_countdown = m_stepLength[m_evenStep];
+            m_evenStep ^= 1;
+        }
+    }
+    
+    /**
+    @brief Set the step length
+    @param ticks Number of clock ticks per step without swing, e.g. 6 for 1/16 notes at 24 ppqn. A step length of 0 is ignored
+    */
+    constexpr void setStepLength(const uint8_t ticks)
+    {
+        if (0 == ticks)
+        {
+            return;
+        }
+        
+        m_ticksPerStep = ticks;
+        updateStepLength();
+    }
+    
+    /**
+    @brief Set the swing amount
+    @param percent Length of an odd-numbered step relative to the length of two steps in percent, 50 = no swing, 66 = triplet swing. Values outside 50..100 are limited to this range
+    */
+    constexpr void setSwing(const uint8_t percent)
+    {
+        m_swing = percent;
+        updateStepLength();
+    }
+    
+    /**
+    @brief Reset the swing stage, the next clock tick triggers an odd-numbered step
+    */
+    constexpr void reset()
+    {
+        m_countdown = 1;
+        m_evenStep = 0;
+    }
+    
+    private:
+    
+    // Calculate the length of odd- and even-numbered steps in ticks
+    constexpr void updateStepLength()
+    {
+        // Swing delay of even-numbered steps in ticks, rounded to the nearest tick. The even-numbered step must last at least one tick
+        const uint8_t swing = (m_swing < 50) ? 50 : (m_swing > 100) ? 100 : m_swing;
+        uint8_t delay = static_cast<uint8_t>((static_cast<uint16_t>(m_ticksPerStep) * ((swing - 50) << 1) + 50) / 100);
+        if (delay >= m_ticksPerStep)
+        {
+            delay = m_ticksPerStep - 1;
+        }
+        
+        m_stepLength[0] = static_cast<uint16_t>(m_ticksPerStep) + delay;
+        m_stepLength[1] = m_ticksPerStep - delay;
+    }
+    
+    // Number of ticks per step without swing
+    uint8_t m_ticksPerStep = 6;
+    
+    // Swing amount in percent
+    uint8_t m_swing = 50;
+    
+    // Length of odd- and even-numbered steps in ticks. The odd-numbered step may last up to two steps, e.g. 383 ticks for 1/4 notes at 192 ppqn
+    uint16_t m_stepLength[2] = {6, 6};
+    
+    // Ticks until the next step
+    uint16_t m_countdown = 1;
+    
+    // Flag indicating that the next step is an even-numbered step
+    uint8_t m_evenStep = 0;
+};
+
+#endif